@@ -0,0 +1,74 @@
+#include "async-agent.h"
+#include <algorithm>
+#include <chrono>
+
+AsyncAgent::AsyncAgent(Policy decide) : policy(std::move(decide))
+{
+    worker = std::thread(&AsyncAgent::run, this);
+}
+
+AsyncAgent::~AsyncAgent()
+{
+    stopping.store(true, std::memory_order_relaxed);
+    worker.join();
+}
+
+// Agent thread: decide on the newest snapshot, idle when there is none
+void AsyncAgent::run()
+{
+    int idle = 0;
+    Snapshot snapshot;
+    while (!stopping.load(std::memory_order_relaxed))
+    {
+        if (!snapshots.pop_latest(snapshot))
+        {
+            if (++idle < IDLE_SPINS)
+            {
+                std::this_thread::yield();
+            }
+            else
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds(IDLE_SLEEP_US));
+            }
+            continue;
+        }
+        idle = 0;
+
+        int move = policy(snapshot.state);
+        decision.store((static_cast<uint64_t>(snapshot.tick + 1) << 2) | static_cast<uint64_t>(move & 3), std::memory_order_release);
+        decisions.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void AsyncAgent::publish(long tick, const GameState& state)
+{
+    ++stats.published;
+    if (!snapshots.push({tick, state}))
+    {
+        ++stats.dropped;
+    }
+}
+
+int AsyncAgent::latest_move(long tick, int default_move)
+{
+    ++stats.reads;
+    uint64_t word = decision.load(std::memory_order_acquire);
+    if (word == 0)
+    {
+        ++stats.undecided;
+        return default_move;
+    }
+
+    long decided_tick = static_cast<long>(word >> 2) - 1;
+    long staleness = std::max(0L, tick - decided_tick);
+    stats.total_staleness += staleness;
+    stats.max_staleness = std::max(stats.max_staleness, staleness);
+    return static_cast<int>(word & 3);
+}
+
+AsyncAgent::Stats AsyncAgent::get_stats() const
+{
+    Stats copy = stats;
+    copy.decisions = decisions.load(std::memory_order_relaxed);
+    return copy;
+}
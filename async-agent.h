@@ -0,0 +1,88 @@
+#ifndef PONG_ASYNC_AGENT_H
+#define PONG_ASYNC_AGENT_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include "config.h"
+#include "spsc-ring.h"
+
+// Runs a policy on its own thread so a slow decision never stalls the
+// game loop. The game publishes (tick, GameState) snapshots through an
+// SPSC ring, and the agent always decides on the newest one, skipping any
+// that piled up. The latest move and the tick of the state it was decided
+// on share one atomic word, so reading them back takes no lock.
+//
+// publish and latest_move belong to the game thread. The policy runs only
+// on the agent thread.
+class AsyncAgent
+{
+public:
+    using Policy = std::function<int(const GameState&)>;
+
+    // Decision staleness seen by the game, in ticks between the state a
+    // move was decided on and the tick it was used
+    struct Stats
+    {
+        long published = 0;
+        long dropped = 0;    // ring full, snapshot not sent
+        long decisions = 0;  // moves the agent produced
+        long reads = 0;      // latest_move calls
+        long undecided = 0;  // reads before the first decision
+        long total_staleness = 0;
+        long max_staleness = 0;
+
+        double mean_staleness() const
+        {
+            long decided = reads - undecided;
+            return decided > 0 ? static_cast<double>(total_staleness) / decided : 0.0;
+        }
+    };
+
+private:
+    struct Snapshot
+    {
+        long tick;
+        GameState state;
+    };
+
+    static const std::size_t RING_SIZE = 64;
+
+    // Agent thread sleeps this long once the ring stayed empty for a while
+    static const int IDLE_SPINS = 64;
+    static const int IDLE_SLEEP_US = 100;
+
+    Policy policy;
+    SpscRing<Snapshot, RING_SIZE> snapshots;
+
+    // (tick + 1) << 2 | move, 0 until the first decision
+    std::atomic<uint64_t> decision{0};
+    std::atomic<long> decisions{0};
+    std::atomic<bool> stopping{false};
+
+    // Game thread only
+    Stats stats;
+
+    std::thread worker;
+
+    void run();
+
+public:
+    explicit AsyncAgent(Policy decide);
+    ~AsyncAgent();
+
+    AsyncAgent(const AsyncAgent&) = delete;
+    AsyncAgent& operator=(const AsyncAgent&) = delete;
+
+    // Hand the agent the state of this tick, never blocks
+    void publish(long tick, const GameState& state);
+
+    // Newest decided move (default_move before the first one), recording
+    // how many ticks old it is at tick
+    int latest_move(long tick, int default_move);
+
+    Stats get_stats() const;
+};
+
+#endif
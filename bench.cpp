@@ -0,0 +1,1065 @@
+// Benchmark suite for training, inference, simulation and dataset I/O.
+// Runs without a display; prints results and writes them as JSON.
+
+#include "network.h"
+#include "quantized-network.h"
+#include "fixed-network.h"
+#include "inference-plan.h"
+#include "config.h"
+#include "train-data.h"
+#include "dataset.h"
+#include "pong-sim.h"
+#include "pong-batch.h"
+#include "buffered-writer.h"
+#include "scratch-arena.h"
+#include "frame-profiler.h"
+#include "async-agent.h"
+#include "spsc-ring.h"
+#include "training-metrics.h"
+#include "sweep.h"
+#include "evolution.h"
+#include "online-learner.h"
+#include "intercept.h"
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <thread>
+
+using namespace std;
+
+// Access to the network's private propagation steps
+class NetworkBenchmark
+{
+public:
+    static const double* forward(const PongNeuralNetwork& network, const GameState& state, InferenceWorkspace& workspace)
+    {
+        return network.infer(state, workspace);
+    }
+
+    static void train_step(PongNeuralNetwork& network, const GameState& state, int target, double learning_rate, ScratchArena& arena)
+    {
+        PongNeuralNetwork::EpochStats stats;
+        network.train_step(state, target, learning_rate, arena, stats);
+    }
+};
+
+// One measured value
+struct BenchResult
+{
+    std::string name;
+    std::string config;
+    double value;
+    std::string unit;
+};
+
+static std::vector<BenchResult> results;
+
+static void record(const std::string& name, const std::string& config, double value, const std::string& unit)
+{
+    results.push_back({name, config, value, unit});
+    cout << "  " << name;
+    if (!config.empty())
+    {
+        cout << " [" << config << "]";
+    }
+    cout << ": " << value << " " << unit << "\n";
+}
+
+static double seconds_since(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static std::string arch_name(const std::vector<int>& arch)
+{
+    std::string name;
+    for (size_t i = 0; i < arch.size(); ++i)
+    {
+        name += (i ? "-" : "") + std::to_string(arch[i]);
+    }
+    return name;
+}
+
+// Silence the per-epoch training output while timing
+class QuietCout
+{
+private:
+    std::ostringstream sink;
+    std::streambuf* saved;
+
+public:
+    QuietCout() : saved(cout.rdbuf(sink.rdbuf())) {}
+    ~QuietCout() { cout.rdbuf(saved); }
+};
+
+// Percentile of an unsorted sample (sorts in place)
+static double percentile(std::vector<double>& samples, double fraction)
+{
+    std::sort(samples.begin(), samples.end());
+    size_t index = static_cast<size_t>(fraction * (samples.size() - 1));
+    return samples[index];
+}
+
+
+
+// Benchmarks --------------------------------------------------------------
+
+static void bench_propagation(const std::vector<int>& arch, long iterations)
+{
+    PongNeuralNetwork network(arch, 1);
+    std::string config = arch_name(arch);
+    InferenceWorkspace workspace;
+    network.prepare_workspace(workspace);
+
+    double sink = 0.0;
+    auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < iterations; ++i)
+    {
+        GameState state = {static_cast<int>(i % 97), 250};
+        sink += NetworkBenchmark::forward(network, state, workspace)[0];
+    }
+    record("forward", config, seconds_since(start) * 1e9 / iterations, "ns/call");
+
+    // Forward, backward and update for one sample
+    ScratchArena arena;
+    start = std::chrono::steady_clock::now();
+    for (long i = 0; i < iterations; ++i)
+    {
+        NetworkBenchmark::train_step(network, {static_cast<int>(i % 97), 250}, 0, 1e-9, arena);
+    }
+    record("train_step", config, seconds_since(start) * 1e9 / iterations, "ns/call");
+
+    // Per-call predict latency distribution
+    std::vector<double> latencies(iterations);
+    for (long i = 0; i < iterations; ++i)
+    {
+        GameState state = {static_cast<int>(i % SCREEN_HEIGHT), static_cast<int>((i * 7) % (SCREEN_HEIGHT - PADDLE_HEIGHT))};
+        auto call_start = std::chrono::steady_clock::now();
+        sink += network.predict_move(state, workspace);
+        latencies[i] = seconds_since(call_start) * 1e9;
+    }
+    record("predict_move_p50", config, percentile(latencies, 0.50), "ns");
+    record("predict_move_p99", config, percentile(latencies, 0.99), "ns");
+
+    // Keep the compiler from dropping the loops
+    volatile double keep = sink;
+    (void)keep;
+}
+
+static void bench_training(const std::vector<int>& arch, const TrainingView& data, int epochs, const std::vector<int>& thread_counts)
+{
+    std::string config = arch_name(arch);
+
+    // Per-sample SGD
+    {
+        PongNeuralNetwork network(arch, 1);
+        double seconds;
+        {
+            QuietCout quiet;
+            auto start = std::chrono::steady_clock::now();
+            network.train(data, 0.0001, epochs);
+            seconds = seconds_since(start) / epochs;
+        }
+        record("train_epoch_sgd", config, seconds * 1e3, "ms/epoch");
+    }
+
+    // Per-sample SGD again, collecting detailed metrics into a sink that
+    // drops them, so the difference is the cost of the telemetry itself
+    {
+        PongNeuralNetwork network(arch, 1);
+        SilentTrainingSink sink;
+        TrainOptions options;
+        options.sink = &sink;
+        options.detailed_metrics = true;
+
+        auto start = std::chrono::steady_clock::now();
+        network.train(data, 0.0001, epochs, options);
+        double seconds = seconds_since(start) / epochs;
+        record("train_epoch_sgd_metrics", config, seconds * 1e3, "ms/epoch");
+    }
+
+    // Mini-batch at several thread counts
+    for (int threads : thread_counts)
+    {
+        PongNeuralNetwork network(arch, 1);
+        TrainOptions options;
+        options.batch_size = 64;
+        options.num_threads = threads;
+
+        double seconds;
+        {
+            QuietCout quiet;
+            auto start = std::chrono::steady_clock::now();
+            network.train(data, 0.01, epochs, options);
+            seconds = seconds_since(start) / epochs;
+        }
+        record("train_epoch_batch64", config + " threads=" + std::to_string(threads), seconds * 1e3, "ms/epoch");
+        record("train_samples_per_second", config + " threads=" + std::to_string(threads), data.size / seconds, "samples/s");
+    }
+}
+
+static void bench_simulation(const PongNeuralNetwork& network, long ticks)
+{
+    PongStateGenerator oracle;
+
+    PongSimulation oracle_sim;
+    SimReport report = run_headless(oracle_sim, [&](const GameState& state) {
+        return oracle.calculate_movement(state);
+    }, ticks);
+    record("sim_ticks_per_second", "oracle policy", report.ticks_per_second(), "ticks/s");
+
+    PongSimulation network_sim;
+    InferenceWorkspace workspace;
+    report = run_headless(network_sim, [&](const GameState& state) {
+        return network.predict_move(state, workspace);
+    }, ticks / 10);
+    record("sim_ticks_per_second", "network policy", report.ticks_per_second(), "ticks/s");
+
+    const int games = 1024;
+    PongBatchSimulation batch(games, 1);
+    BatchInferenceWorkspace batch_workspace;
+    report = run_headless_batch(batch, [&](const int* bally, const int* paddley, int* moves, int count) {
+        network.predict_moves(bally, paddley, moves, count, batch_workspace);
+    }, std::max(1L, ticks / 10 / games));
+    record("sim_ticks_per_second", "network policy, 1024 games", report.ticks_per_second(), "ticks/s");
+}
+
+// Mean predict_move latency over the grid states
+template <typename Network>
+static double predict_latency(const Network& network, const std::vector<TrainData>& states, long iterations)
+{
+    long sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < iterations; ++i)
+    {
+        const TrainData& state = states[i % states.size()];
+        sink += network.predict_move({state.bally, state.paddley});
+    }
+    double seconds = seconds_since(start);
+
+    volatile long keep = sink;
+    (void)keep;
+    return seconds * 1e9 / iterations;
+}
+
+// Double, float and int8 copies of one trained network: size, speed and
+// how often they pick the same move as the double model on the full grid
+static void bench_precision(const std::vector<int>& arch, const TrainingView& data, int epochs, long iterations)
+{
+    PongStateGenerator generator;
+    std::vector<TrainData> states = generator.generateStates();
+    std::string config = arch_name(arch);
+
+    PongNeuralNetwork network(arch, 1);
+    PongNeuralNetworkF trained_float(arch, 1);
+    double double_seconds, float_seconds;
+    {
+        QuietCout quiet;
+        auto start = std::chrono::steady_clock::now();
+        network.train(data, 0.0001, epochs);
+        double_seconds = seconds_since(start) / epochs;
+
+        start = std::chrono::steady_clock::now();
+        trained_float.train(data, 0.0001, epochs);
+        float_seconds = seconds_since(start) / epochs;
+    }
+    record("train_epoch_sgd", config + " double", double_seconds * 1e3, "ms/epoch");
+    record("train_epoch_sgd", config + " float", float_seconds * 1e3, "ms/epoch");
+
+    PongNeuralNetworkF converted(network);
+    QuantizedPongNetwork quantized;
+    quantized.quantize(network);
+    InferencePlan plan;
+    plan.compile(network);
+
+    record("model_bytes", config + " double", network.parameter_bytes(), "bytes");
+    record("model_bytes", config + " float", converted.parameter_bytes(), "bytes");
+    record("model_bytes", config + " int8", quantized.parameter_bytes(), "bytes");
+
+    record("predict_move_mean", config + " double", predict_latency(network, states, iterations), "ns");
+    record("predict_move_mean", config + " float", predict_latency(converted, states, iterations), "ns");
+    record("predict_move_mean", config + " int8", predict_latency(quantized, states, iterations), "ns");
+    record("predict_move_mean", config + " plan", predict_latency(plan, states, iterations), "ns");
+
+    record("move_agreement", config + " float vs double", move_agreement(network, converted, states) * 100.0, "%");
+    record("move_agreement", config + " int8 vs double", move_agreement(network, quantized, states) * 100.0, "%");
+    record("move_agreement", config + " plan vs double", move_agreement(network, plan, states) * 100.0, "%");
+    record("move_agreement", config + " float trained vs double", move_agreement(network, trained_float, states) * 100.0, "%");
+
+    // The stored int8 model, read back into the padded in-memory layout
+    const std::string doublefile = "bench_model.bin";
+    const std::string int8file = "bench_model.q8";
+    QuantizedPongNetwork reloaded;
+    {
+        QuietCout quiet;
+        network.save(doublefile);
+        quantized.save(int8file);
+    }
+    for (const auto& saved : {std::make_pair(doublefile, " double"), std::make_pair(int8file, " int8")})
+    {
+        std::ifstream file(saved.first, std::ios::binary | std::ios::ate);
+        record("model_file_bytes", config + saved.second, static_cast<double>(file.tellg()), "bytes");
+    }
+    if (reloaded.load(int8file))
+    {
+        record("move_agreement", config + " int8 loaded vs double", move_agreement(network, reloaded, states) * 100.0, "%");
+    }
+    std::remove(doublefile.c_str());
+    std::remove(int8file.c_str());
+}
+
+// Compile time architecture against the dynamic network with the same weights
+template <typename Fixed>
+static void bench_fixed(const TrainingView& data, int epochs, long iterations)
+{
+    PongStateGenerator generator;
+    std::vector<TrainData> states = generator.generateStates();
+    std::vector<int> arch(Fixed::LAYER_SIZES.begin(), Fixed::LAYER_SIZES.end());
+    std::string config = arch_name(arch);
+
+    PongNeuralNetwork network(arch, 1);
+    Fixed fixed(1);
+    double dynamic_seconds, fixed_seconds;
+    {
+        QuietCout quiet;
+        auto start = std::chrono::steady_clock::now();
+        network.train(data, 0.0001, epochs);
+        dynamic_seconds = seconds_since(start) / epochs;
+
+        start = std::chrono::steady_clock::now();
+        fixed.train(data, 0.0001, epochs);
+        fixed_seconds = seconds_since(start) / epochs;
+    }
+    record("train_epoch_sgd", config + " dynamic", dynamic_seconds * 1e3, "ms/epoch");
+    record("train_epoch_sgd", config + " fixed", fixed_seconds * 1e3, "ms/epoch");
+
+    fixed.copy_from(network);
+    record("predict_move_mean", config + " dynamic", predict_latency(network, states, iterations), "ns");
+    record("predict_move_mean", config + " fixed", predict_latency(fixed, states, iterations), "ns");
+    record("move_agreement", config + " fixed vs dynamic", move_agreement(network, fixed, states) * 100.0, "%");
+
+    // Both on the vectorized tanh, where the matrix work is a larger share
+    network.set_math_mode(MathMode::Fast);
+    fixed.set_math_mode(MathMode::Fast);
+    record("predict_move_mean", config + " dynamic fast", predict_latency(network, states, iterations), "ns");
+    record("predict_move_mean", config + " fixed fast", predict_latency(fixed, states, iterations), "ns");
+}
+
+// Share of training samples whose labelled move the network predicts
+template <typename Network>
+static double training_accuracy(const Network& network, const TrainingView& data)
+{
+    size_t correct = 0;
+    for (size_t i = 0; i < data.size; ++i)
+    {
+        correct += network.predict_move({data.bally_at(i), data.paddley_at(i)}) == data.moves[i];
+    }
+    return static_cast<double>(correct) / std::max<size_t>(data.size, 1);
+}
+
+// Per element cost of one activation kernel over a cache resident buffer
+template <typename Kernel>
+static double kernel_ns_per_element(Kernel kernel, std::vector<double>& values, long iterations)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < iterations; ++i)
+    {
+        kernel(values.data(), values.size());
+    }
+    return seconds_since(start) * 1e9 / (static_cast<double>(iterations) * values.size());
+}
+
+// Approximate tanh and exp: kernel speed, measured error, and whether a
+// network trained with them reaches the accuracy of an exact one
+static void bench_math(const std::vector<int>& arch, const TrainingView& data, int epochs, long iterations)
+{
+    std::string config = arch_name(arch);
+    const MathMode modes[] = {MathMode::Exact, MathMode::Fast};
+    const char* mode_names[] = {"exact", "fast"};
+
+    if (arch == std::vector<int>{5, 10, 10, 3})
+    {
+        // Hidden pre-activations and shifted logits both stay in [-8, 0.5]
+        std::vector<double> source(4096), values(4096);
+        for (size_t i = 0; i < source.size(); ++i)
+        {
+            source[i] = -8.0 + 8.5 * i / source.size();
+        }
+        long passes = std::max(1L, iterations / 100);
+        for (int m = 0; m < 2; ++m)
+        {
+            values = source;
+            record("tanh_kernel", mode_names[m], kernel_ns_per_element([&](double* v, size_t n) { tanh_inplace(v, n, modes[m]); }, values, passes), "ns/element");
+            values = source;
+            record("exp_kernel", mode_names[m], kernel_ns_per_element([&](double* v, size_t n) {
+                // Keep the inputs bounded across passes
+                std::copy(source.begin(), source.end(), v);
+                exp_inplace(v, n, modes[m]);
+            }, values, passes), "ns/element");
+        }
+
+        // Worst error against long double libm over a dense sweep
+        const int samples = 1000000;
+        std::vector<double> tanh_values(samples), exp_values(samples);
+        std::vector<float> tanh_floats(samples);
+        for (int i = 0; i < samples; ++i)
+        {
+            tanh_values[i] = -20.0 + 40.0 * i / samples;
+            tanh_floats[i] = static_cast<float>(tanh_values[i]);
+            exp_values[i] = -700.0 + 1400.0 * i / samples;
+        }
+        std::vector<double> tanh_out = tanh_values, exp_out = exp_values;
+        std::vector<float> tanh_float_out = tanh_floats;
+        tanh_inplace(tanh_out.data(), samples, MathMode::Fast);
+        tanh_inplace(tanh_float_out.data(), samples, MathMode::Fast);
+        exp_inplace(exp_out.data(), samples, MathMode::Fast);
+
+        double tanh_error = 0.0, tanh_float_error = 0.0, exp_error = 0.0;
+        for (int i = 0; i < samples; ++i)
+        {
+            tanh_error = std::max(tanh_error, static_cast<double>(std::fabs(tanh_out[i] - std::tanh(static_cast<long double>(tanh_values[i])))));
+            tanh_float_error = std::max(tanh_float_error, static_cast<double>(std::fabs(tanh_float_out[i] - std::tanh(static_cast<long double>(tanh_floats[i])))));
+            long double exact = std::exp(static_cast<long double>(exp_values[i]));
+            exp_error = std::max(exp_error, static_cast<double>(std::fabs((exp_out[i] - exact) / exact)));
+        }
+        record("tanh_max_abs_error", "fast double", tanh_error, "abs");
+        record("tanh_max_abs_error", "fast float", tanh_float_error, "abs");
+        record("exp_max_rel_error", "fast double", exp_error, "rel");
+    }
+
+    // Same seed in both modes, so any accuracy gap comes from the math
+    PongNeuralNetwork exact(arch, 1), fast(arch, 1);
+    PongNeuralNetwork* networks[2] = {&exact, &fast};
+    PongStateGenerator generator;
+    std::vector<TrainData> states = generator.generateStates();
+    for (int m = 0; m < 2; ++m)
+    {
+        PongNeuralNetwork& network = *networks[m];
+        network.set_math_mode(modes[m]);
+        double seconds;
+        {
+            QuietCout quiet;
+            auto start = std::chrono::steady_clock::now();
+            network.train(data, 0.0001, epochs);
+            seconds = seconds_since(start) / epochs;
+        }
+        record("train_epoch_sgd", config + " " + mode_names[m], seconds * 1e3, "ms/epoch");
+        record("training_accuracy", config + " " + mode_names[m], training_accuracy(network, data) * 100.0, "%");
+        record("predict_move_mean", config + " " + mode_names[m], predict_latency(network, states, iterations), "ns");
+    }
+    record("move_agreement", config + " fast vs exact", move_agreement(exact, fast, states) * 100.0, "%");
+}
+
+// Table of every state against running the network, per architecture
+static void bench_policy_table(const std::vector<int>& arch, const TrainingView& data, int epochs, long iterations)
+{
+    PongStateGenerator generator;
+    std::vector<TrainData> states = generator.generateStates();
+    std::string config = arch_name(arch);
+
+    PongNeuralNetwork network(arch, 1);
+    {
+        QuietCout quiet;
+        network.train(data, 0.0001, epochs);
+    }
+
+    PongNeuralNetwork tabled(network);
+    auto start = std::chrono::steady_clock::now();
+    tabled.enable_policy_table(true);
+    record("policy_table_build", config, seconds_since(start) * 1e3, "ms");
+    record("policy_table_bytes", config, tabled.policy_table_bytes(), "bytes");
+
+    record("predict_move_mean", config + " network", predict_latency(network, states, iterations), "ns");
+    record("predict_move_mean", config + " table", predict_latency(tabled, states, iterations), "ns");
+    record("move_agreement", config + " table vs network", move_agreement(network, tabled, states) * 100.0, "%");
+}
+
+// A small grid trained one configuration at a time and then on every core
+static void bench_sweep(const TrainingView& data, int epochs)
+{
+    SweepSpace space;
+    space.hidden_layers = {{10, 10}, {32, 32}};
+    space.learning_rates = {0.001};
+    space.epochs = {epochs, epochs * 4};
+    space.batch_sizes = {1, 32};
+    std::vector<SweepConfig> configs = space.grid();
+    std::vector<TrainData> holdout = holdout_states(data);
+    std::string config = std::to_string(configs.size()) + " configs";
+
+    SweepOptions options;
+    options.play_ticks = 5000;
+
+    std::vector<int> thread_counts{1};
+    int cores = static_cast<int>(std::thread::hardware_concurrency());
+    if (cores > 1)
+    {
+        thread_counts.push_back(cores);
+    }
+
+    for (int threads : thread_counts)
+    {
+        options.threads = threads;
+        auto start = std::chrono::steady_clock::now();
+        std::vector<SweepResult> results = run_sweep(configs, data, holdout, options);
+        double seconds = seconds_since(start);
+        record("sweep_seconds", config + " threads=" + std::to_string(threads), seconds, "s");
+
+        rank_sweep_results(results);
+        record("sweep_best_holdout", config + " threads=" + std::to_string(threads), results[0].holdout_accuracy * 100.0, "%");
+    }
+}
+
+// Cloning a network, and generations of neuroevolution scored by play
+static void bench_evolution(const std::vector<int>& arch, long iterations, int generations)
+{
+    std::string config = arch_name(arch);
+    PongNeuralNetwork network(arch, 1);
+
+    long copies = std::max(1L, iterations / 10);
+    double sink = 0.0;
+    auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < copies; ++i)
+    {
+        PongNeuralNetwork copy(network);
+        PongNeuralNetwork moved(std::move(copy));
+        sink += moved.get_parameters()[0];
+    }
+    record("network_copy_and_move", config, seconds_since(start) * 1e9 / copies, "ns");
+    volatile double keep = sink;
+    (void)keep;
+
+    EvolutionOptions options;
+    options.population = 32;
+    options.play_ticks = 2000;
+    options.verbose = false;
+    NeuroEvolution evolution(network, options);
+    std::vector<GenerationStats> history = evolution.run(generations);
+
+    double seconds = 0.0;
+    for (const GenerationStats& stats : history)
+    {
+        seconds += stats.seconds;
+    }
+    record("evolution_evaluations_per_second", config + " population=32", options.population * generations / seconds, "evals/s");
+    record("evolution_best_fitness", config + " generations=" + std::to_string(generations), evolution.get_best_fitness(), "fitness");
+}
+
+// Deciding through the online learner's double buffer while it retrains,
+// in a headless loop that yields every tick like a paced game would
+static void bench_online(const TrainingView& data, long ticks)
+{
+    PongNeuralNetwork network({5, 10, 10, 3}, 1);
+    {
+        QuietCout quiet;
+        network.train(data, 0.0001, 2);
+    }
+    double accuracy_before = training_accuracy(network, data);
+
+    PongStateGenerator teacher;
+    OnlineLearner::Options options;
+    options.update_samples = 256;
+    OnlineLearner learner(network, [teacher](const GameState& state) mutable {
+        return teacher.calculate_movement(state);
+    }, options);
+
+    LatencyHistogram latency;
+    PongSimulation sim;
+    for (long t = 0; t < ticks; ++t)
+    {
+        auto start = std::chrono::steady_clock::now();
+        int move = learner.predict_move(sim.state());
+        latency.record(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+
+        learner.record(sim.state());
+        sim.step(move);
+        std::this_thread::yield();
+    }
+
+    OnlineLearner::Stats stats = learner.get_stats();
+    record("online_predict_p50", "during updates", latency.percentile(0.5), "ns");
+    record("online_predict_p99", "during updates", latency.percentile(0.99), "ns");
+    record("online_updates", std::to_string(ticks) + " ticks", stats.updates, "updates");
+    record("online_dropped", std::to_string(ticks) + " ticks", 100.0 * stats.dropped / std::max(1L, stats.recorded), "%");
+    record("online_update_ms", "replay " + std::to_string(options.replay_capacity), stats.last_update_seconds * 1e3, "ms");
+    record("training_accuracy", "online before", accuracy_before * 100.0, "%");
+    record("training_accuracy", "online after", training_accuracy(learner.snapshot(), data) * 100.0, "%");
+}
+
+// Intercept by stepping the ball under the simulation's wall rules, what
+// the closed form replaces
+static Intercept stepped_intercept(int x, int y, int dx, int dy)
+{
+    if (dx == 0)
+    {
+        return {y, -1};
+    }
+    int ticks = 0;
+    while (!(x < PADDLE_X + PADDLE_WIDTH && dx < 0))
+    {
+        x += dx;
+        y += dy;
+        if (y <= BALL_SIZE || y >= SCREEN_HEIGHT - BALL_SIZE)
+        {
+            dy = -dy;
+        }
+        if (x >= SCREEN_WIDTH - BALL_SIZE)
+        {
+            dx = -dx;
+        }
+        ++ticks;
+    }
+    return {y, ticks};
+}
+
+// Closed form intercept against stepping: agreement, cost per ball scalar
+// and batched, and how the baseline it gives plays next to the 2 input oracle
+static void bench_intercept(long iterations, long ticks)
+{
+    const int count = 4096;
+    std::mt19937 rng(1);
+    std::vector<int> x(count), y(count), dx(count), dy(count), paddley(count);
+    for (int i = 0; i < count; ++i)
+    {
+        int speed_x = 1 + rng() % 14;
+        int speed_y = rng() % 14;
+        dx[i] = rng() % 2 ? speed_x : -speed_x;
+        dy[i] = rng() % 2 ? speed_y : -speed_y;
+        x[i] = PADDLE_X + PADDLE_WIDTH + rng() % (SCREEN_WIDTH - BALL_SIZE - PADDLE_X - PADDLE_WIDTH);
+        y[i] = BALL_SIZE + 1 + rng() % (SCREEN_HEIGHT - 2 * BALL_SIZE - 1);
+        paddley[i] = rng() % (SCREEN_HEIGHT - PADDLE_HEIGHT);
+    }
+
+    int agree = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        Intercept closed = find_intercept(x[i], y[i], dx[i], dy[i]);
+        Intercept stepped = stepped_intercept(x[i], y[i], dx[i], dy[i]);
+        agree += closed.y == stepped.y && closed.ticks == stepped.ticks;
+    }
+    record("intercept_agreement", "closed form vs stepped", 100.0 * agree / count, "%");
+
+    long passes = std::max(1L, iterations / count);
+    long sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (long pass = 0; pass < passes; ++pass)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            sink += stepped_intercept(x[i], y[i], dx[i], dy[i]).y;
+        }
+    }
+    record("intercept_latency", "stepped", seconds_since(start) * 1e9 / (passes * count), "ns/ball");
+
+    start = std::chrono::steady_clock::now();
+    for (long pass = 0; pass < passes; ++pass)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            sink += find_intercept(x[i], y[i], dx[i], dy[i]).y;
+        }
+    }
+    record("intercept_latency", "closed form", seconds_since(start) * 1e9 / (passes * count), "ns/ball");
+
+    std::vector<int> hit_y(count), hit_ticks(count), moves(count);
+    start = std::chrono::steady_clock::now();
+    for (long pass = 0; pass < passes; ++pass)
+    {
+        find_intercepts(x.data(), y.data(), dx.data(), dy.data(), hit_y.data(), hit_ticks.data(), count);
+        sink += hit_y[pass % count];
+    }
+    record("intercept_latency", "closed form, batch of 4096", seconds_since(start) * 1e9 / (passes * count), "ns/ball");
+
+    start = std::chrono::steady_clock::now();
+    for (long pass = 0; pass < passes; ++pass)
+    {
+        intercept_moves(x.data(), y.data(), dx.data(), dy.data(), paddley.data(), moves.data(), count);
+        sink += moves[pass % count];
+    }
+    record("intercept_label_latency", "batch of 4096", seconds_since(start) * 1e9 / (passes * count), "ns/state");
+
+    volatile long keep = sink;
+    (void)keep;
+
+    PongStateGenerator oracle;
+    PongSimulation oracle_sim;
+    SimReport report = run_headless(oracle_sim, [&](const GameState& state) {
+        return oracle.calculate_movement(state);
+    }, ticks);
+    record("hits_per_rally", "oracle policy", report.hits_per_rally(), "hits");
+
+    PongSimulation baseline_sim;
+    report = run_headless(baseline_sim, [&](const GameState&) {
+        return intercept_policy(baseline_sim);
+    }, ticks);
+    record("hits_per_rally", "intercept policy", report.hits_per_rally(), "hits");
+    record("sim_ticks_per_second", "intercept policy", report.ticks_per_second(), "ticks/s");
+
+    const int games = 1024;
+    PongBatchSimulation batch(games, 1);
+    report = run_headless_batch(batch, [&](const int* bally, const int* paddle, int* batch_moves, int n) {
+        intercept_moves(batch.ballx(), bally, batch.speedx(), batch.speedy(), paddle, batch_moves, n);
+    }, std::max(1L, ticks / games));
+    record("sim_ticks_per_second", "intercept policy, 1024 games", report.ticks_per_second(), "ticks/s");
+}
+
+// Uniform grid against boundary focused samples at shrinking budgets, all
+// trained the same way and scored on a finer grid than any of them
+static void bench_adaptive(int epochs)
+{
+    PongStateGenerator fine(5, 5);
+    std::vector<TrainData> evaluation = fine.generateStates();
+
+    for (size_t budget : {size_t(0), size_t(1500), size_t(750)})
+    {
+        PongStateGenerator generator;
+        generator.setAdaptiveBudget(budget);
+        std::vector<TrainData> states = generator.generateStates();
+
+        std::vector<int> bally, paddley, moves;
+        for (const TrainData& state : states)
+        {
+            bally.push_back(state.bally);
+            paddley.push_back(state.paddley);
+            moves.push_back(state.optimalmove);
+        }
+        TrainingView view;
+        view.bally = bally.data();
+        view.paddley = paddley.data();
+        view.moves = moves.data();
+        view.size = states.size();
+
+        PongNeuralNetwork network({5, 10, 10, 3}, 1);
+        double seconds;
+        {
+            QuietCout quiet;
+            auto start = std::chrono::steady_clock::now();
+            network.train(view, 0.001, epochs);
+            seconds = seconds_since(start) / epochs;
+        }
+
+        size_t correct = 0;
+        for (const TrainData& state : evaluation)
+        {
+            correct += network.predict_move({state.bally, state.paddley}) == state.optimalmove;
+        }
+
+        std::string config = budget == 0 ? std::string("grid") : "adaptive " + std::to_string(budget);
+        DatasetStats stats = compute_dataset_stats(view);
+        record("dataset_rows", config, stats.count, "rows");
+        record("dataset_near_boundary", config, 100.0 * stats.near_boundary / std::max<size_t>(stats.count, 1), "%");
+        record("train_epoch_sgd", config, seconds * 1e3, "ms/epoch");
+        record("fine_grid_accuracy", config + " epochs=" + std::to_string(epochs), 100.0 * correct / evaluation.size(), "%");
+    }
+}
+
+// Cost of the frame timers, and a headless game loop traced through them
+static void bench_profiler(const PongNeuralNetwork& network, long iterations)
+{
+    for (bool enabled : {false, true})
+    {
+        FrameProfiler profiler(enabled);
+        auto start = std::chrono::steady_clock::now();
+        for (long i = 0; i < iterations; ++i)
+        {
+            FrameProfiler::Scope timer(profiler, FramePhase::Physics);
+        }
+        record("profiler_scope", enabled ? "enabled" : "disabled", seconds_since(start) * 1e9 / iterations, "ns/scope");
+    }
+
+    FrameProfiler profiler(true);
+    PongSimulation sim;
+    InferenceWorkspace workspace;
+    for (long i = 0; i < iterations; ++i)
+    {
+        profiler.begin_frame();
+        int move;
+        {
+            FrameProfiler::Scope timer(profiler, FramePhase::Inference);
+            move = network.predict_move(sim.state(), workspace);
+        }
+        {
+            FrameProfiler::Scope timer(profiler, FramePhase::Physics);
+            sim.step(move);
+        }
+        profiler.end_frame();
+    }
+    record("headless_frame_p50", "inference", profiler.histogram(FramePhase::Inference).percentile(0.50), "ns");
+    record("headless_frame_p99", "inference", profiler.histogram(FramePhase::Inference).percentile(0.99), "ns");
+    record("headless_frame_p50", "physics", profiler.histogram(FramePhase::Physics).percentile(0.50), "ns");
+    record("headless_frame_p99", "physics", profiler.histogram(FramePhase::Physics).percentile(0.99), "ns");
+
+    auto start = std::chrono::steady_clock::now();
+    profiler.write_trace("bench_trace.csv");
+    record("profiler_trace_write", "3600 frames csv", seconds_since(start) * 1e3, "ms");
+    std::remove("bench_trace.csv");
+}
+
+// SPSC ring throughput, and the game thread cost of synchronous against
+// asynchronous decisions with a heavy network
+static void bench_async_agent(const TrainingView& data, long ticks)
+{
+    // Producer and consumer on two threads, values must arrive in order
+    {
+        SpscRing<long, 1024> ring;
+        const long count = ticks * 10;
+        bool ordered = true;
+        auto start = std::chrono::steady_clock::now();
+        std::thread consumer([&]() {
+            long expected = 0, value;
+            while (expected < count)
+            {
+                if (ring.pop(value))
+                {
+                    ordered = ordered && value == expected;
+                    ++expected;
+                }
+                else
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+        for (long i = 0; i < count;)
+        {
+            if (ring.push(i))
+            {
+                ++i;
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+        consumer.join();
+        record("spsc_ring", ordered ? "2 threads, in order" : "2 threads, OUT OF ORDER", count / seconds_since(start), "items/s");
+    }
+
+    PongNeuralNetwork network({5, 64, 64, 64, 3}, 1);
+    {
+        QuietCout quiet;
+        network.train(data, 0.0001, 1);
+    }
+
+    // Ticks are spaced out like frames so the agent thread gets a turn
+    const auto frame_gap = std::chrono::microseconds(200);
+    double work_seconds = 0.0;
+    {
+        PongSimulation sim;
+        InferenceWorkspace workspace;
+        for (long t = 0; t < ticks; ++t)
+        {
+            auto start = std::chrono::steady_clock::now();
+            sim.step(network.predict_move(sim.state(), workspace));
+            work_seconds += seconds_since(start);
+            std::this_thread::sleep_for(frame_gap);
+        }
+    }
+    record("game_tick_cost", "5-64-64-64-3 sync", work_seconds * 1e9 / ticks, "ns/tick");
+
+    work_seconds = 0.0;
+    AsyncAgent::Stats stats;
+    {
+        AsyncAgent agent([&](const GameState& state) { return network.predict_move(state); });
+        PongSimulation sim;
+        for (long t = 0; t < ticks; ++t)
+        {
+            auto start = std::chrono::steady_clock::now();
+            agent.publish(sim.get_ticks(), sim.state());
+            sim.step(agent.latest_move(sim.get_ticks(), MOVE_NONE));
+            work_seconds += seconds_since(start);
+            std::this_thread::sleep_for(frame_gap);
+        }
+        stats = agent.get_stats();
+    }
+    record("game_tick_cost", "5-64-64-64-3 async", work_seconds * 1e9 / ticks, "ns/tick");
+    record("decision_staleness_mean", "5-64-64-64-3 async", stats.mean_staleness(), "ticks");
+    record("decision_staleness_max", "5-64-64-64-3 async", stats.max_staleness, "ticks");
+    record("snapshots_dropped", "5-64-64-64-3 async", stats.dropped, "snapshots");
+}
+
+static void bench_io(const std::vector<int>& grid_steps)
+{
+    const std::string csvfile = "bench_states.csv";
+    const std::string binfile = "bench_states.bin";
+
+    for (int step : grid_steps)
+    {
+        PongStateGenerator generator(step, step);
+        std::string config = "grid step " + std::to_string(step);
+        double rows, generate_seconds, read_seconds, load_seconds, binary_seconds;
+
+        {
+            QuietCout quiet;
+
+            auto start = std::chrono::steady_clock::now();
+            generator.generateDataCSV(csvfile);
+            generate_seconds = seconds_since(start);
+
+            start = std::chrono::steady_clock::now();
+            std::vector<TrainData> states = generator.readCSV(csvfile);
+            read_seconds = seconds_since(start);
+            rows = static_cast<double>(states.size());
+
+            TrainingDataset dataset;
+            start = std::chrono::steady_clock::now();
+            dataset.load(csvfile);
+            load_seconds = seconds_since(start);
+
+            dataset.write_binary(binfile);
+            TrainingDataset binary;
+            start = std::chrono::steady_clock::now();
+            binary.load(binfile);
+            binary_seconds = seconds_since(start);
+        }
+
+        record("generateDataCSV", config, rows / generate_seconds, "rows/s");
+        record("readCSV", config, rows / read_seconds, "rows/s");
+        record("dataset_load_csv", config, rows / load_seconds, "rows/s");
+        record("dataset_load_binary", config, rows / binary_seconds, "rows/s");
+    }
+
+    std::remove(csvfile.c_str());
+    std::remove(binfile.c_str());
+}
+
+
+
+// Output ------------------------------------------------------------------
+
+static void write_json(const std::string& filename)
+{
+    BufferedWriter json(filename);
+    if (!json.is_open())
+    {
+        std::cerr << "Error opening file: " << filename << std::endl;
+        return;
+    }
+
+    json.write("{\n  \"results\": [\n");
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const BenchResult& result = results[i];
+        json.write("    {\"name\": \"");
+        json.write(result.name);
+        json.write("\", \"config\": \"");
+        json.write(result.config);
+        json.write("\", \"value\": ");
+        json.write_double(result.value);
+        json.write(", \"unit\": \"");
+        json.write(result.unit);
+        json.write(i + 1 < results.size() ? "\"},\n" : "\"}\n");
+    }
+    json.write("  ]\n}\n");
+    json.flush();
+
+    cout << "Wrote " << results.size() << " results to " << filename << "\n";
+}
+
+
+
+int main(int argc, char* argv[])
+{
+    // --quick shortens every run, --json <file> sets the output path
+    bool quick = false;
+    std::string jsonfile = "bench_results.json";
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--quick") == 0)
+        {
+            quick = true;
+        }
+        else if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+        {
+            jsonfile = argv[++i];
+        }
+    }
+
+    const std::vector<std::vector<int>> architectures = {{5, 10, 10, 3}, {5, 32, 32, 3}, {5, 64, 64, 64, 3}};
+    const long iterations = quick ? 20000 : 200000;
+    const int epochs = quick ? 2 : 10;
+    const long ticks = quick ? 1000000 : 10000000;
+
+    std::vector<int> thread_counts = {1};
+    int hardware = static_cast<int>(std::thread::hardware_concurrency());
+    for (int threads = 2; threads <= hardware; threads *= 2)
+    {
+        thread_counts.push_back(threads);
+    }
+
+    // Training data shared by every training benchmark
+    PongStateGenerator generator;
+    TrainingDataset dataset;
+    {
+        QuietCout quiet;
+        generator.generateDataCSV("bench_train.csv");
+        dataset.load("bench_train.csv");
+    }
+    std::remove("bench_train.csv");
+
+    cout << "Propagation and inference\n";
+    for (const auto& arch : architectures)
+    {
+        bench_propagation(arch, iterations);
+    }
+
+    cout << "Training (" << dataset.size() << " samples)\n";
+    for (const auto& arch : architectures)
+    {
+        bench_training(arch, dataset.view(), epochs, thread_counts);
+    }
+
+    cout << "Precision (" << dataset.size() << " samples)\n";
+    for (const auto& arch : architectures)
+    {
+        bench_precision(arch, dataset.view(), epochs * 5, iterations);
+    }
+
+    cout << "Fixed architecture\n";
+    bench_fixed<FixedPongNetwork<5, 10, 10, 3>>(dataset.view(), epochs * 5, iterations);
+    bench_fixed<FixedPongNetwork<5, 32, 32, 3>>(dataset.view(), epochs * 5, iterations);
+
+    cout << "Math mode (" << dataset.size() << " samples)\n";
+    for (const auto& arch : architectures)
+    {
+        bench_math(arch, dataset.view(), epochs * 5, iterations);
+    }
+
+    cout << "Policy table\n";
+    for (const auto& arch : architectures)
+    {
+        bench_policy_table(arch, dataset.view(), epochs, iterations);
+    }
+
+    cout << "Adaptive sampling\n";
+    bench_adaptive(epochs * 15);
+
+    cout << "Sweep\n";
+    bench_sweep(dataset.view(), epochs);
+
+    cout << "Evolution\n";
+    bench_evolution(architectures[0], iterations, quick ? 3 : 10);
+
+    cout << "Simulation\n";
+    PongNeuralNetwork network(architectures[0], 1);
+    bench_simulation(network, ticks);
+
+    cout << "Intercept\n";
+    bench_intercept(iterations, ticks);
+
+    cout << "Async agent\n";
+    bench_async_agent(dataset.view(), quick ? 2000 : 10000);
+
+    cout << "Online learning\n";
+    bench_online(dataset.view(), quick ? 20000 : 100000);
+
+    cout << "Frame profiler\n";
+    bench_profiler(network, iterations);
+
+    cout << "Dataset I/O\n";
+    bench_io(quick ? std::vector<int>{10, 5} : std::vector<int>{10, 5, 2, 1});
+
+    write_json(jsonfile);
+    return 0;
+}
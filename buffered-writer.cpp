@@ -0,0 +1,87 @@
+#include "buffered-writer.h"
+
+BufferedWriter::BufferedWriter(const std::string& filename) : file(std::fopen(filename.c_str(), "wb")), owns_file(true)
+{
+}
+
+BufferedWriter::BufferedWriter(std::FILE* stream) : file(stream), owns_file(false)
+{
+}
+
+BufferedWriter::~BufferedWriter()
+{
+    flush();
+    if (owns_file && file)
+    {
+        std::fclose(file);
+    }
+}
+
+void BufferedWriter::flush_buffer()
+{
+    if (file && used > 0 && std::fwrite(buffer, 1, used, file) != used)
+    {
+        failed = true;
+    }
+    used = 0;
+}
+
+void BufferedWriter::flush()
+{
+    flush_buffer();
+    if (file && std::fflush(file) != 0)
+    {
+        failed = true;
+    }
+}
+
+void BufferedWriter::write(const char* data, size_t length)
+{
+    // Large writes skip the buffer entirely
+    if (length >= BUFFER_SIZE)
+    {
+        flush_buffer();
+        if (file && std::fwrite(data, 1, length, file) != length)
+        {
+            failed = true;
+        }
+        return;
+    }
+
+    if (used + length > BUFFER_SIZE)
+    {
+        flush_buffer();
+    }
+    std::memcpy(buffer + used, data, length);
+    used += length;
+}
+
+void BufferedWriter::write_int(long value)
+{
+    char digits[24];
+    int length = 0;
+    unsigned long magnitude = value < 0 ? 0ul - static_cast<unsigned long>(value) : static_cast<unsigned long>(value);
+
+    // Digits come out in reverse
+    do
+    {
+        digits[length++] = static_cast<char>('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude > 0);
+
+    if (value < 0)
+    {
+        put('-');
+    }
+    while (length > 0)
+    {
+        put(digits[--length]);
+    }
+}
+
+void BufferedWriter::write_double(double value)
+{
+    char text[32];
+    int length = std::snprintf(text, sizeof(text), "%g", value);
+    write(text, static_cast<size_t>(length));
+}
@@ -0,0 +1,64 @@
+#ifndef PONG_BUFFERED_WRITER_H
+#define PONG_BUFFERED_WRITER_H
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+// Streaming writer that formats into a fixed buffer and hands it to the OS
+// in large blocks instead of one formatted write per field
+class BufferedWriter
+{
+private:
+    static const size_t BUFFER_SIZE = 1 << 16;
+
+    std::FILE* file = nullptr;
+    bool owns_file = false;
+    char buffer[BUFFER_SIZE];
+    size_t used = 0;
+    bool failed = false;
+
+public:
+    // Write to a file, truncating it
+    explicit BufferedWriter(const std::string& filename);
+
+    // Write to an already open stream such as stdout (not closed on exit)
+    explicit BufferedWriter(std::FILE* stream);
+
+    ~BufferedWriter();
+
+    BufferedWriter(const BufferedWriter&) = delete;
+    BufferedWriter& operator=(const BufferedWriter&) = delete;
+
+    bool is_open() const { return file != nullptr; }
+
+    // False once any write to the underlying file failed
+    bool good() const { return file && !failed; }
+
+    void write(const char* data, size_t length);
+    void write(const std::string& text) { write(text.data(), text.size()); }
+    void write(const char* text) { write(text, std::strlen(text)); }
+
+    void put(char c)
+    {
+        if (used == BUFFER_SIZE)
+        {
+            flush_buffer();
+        }
+        buffer[used++] = c;
+    }
+
+    // Decimal integer without going through printf
+    void write_int(long value);
+
+    // Floating point value in %g style
+    void write_double(double value);
+
+    // Push buffered bytes to the file and flush it
+    void flush();
+
+private:
+    void flush_buffer();
+};
+
+#endif
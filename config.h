@@ -32,7 +32,8 @@ struct GameState
 const int SCREEN_HEIGHT = 600;
 const int SCREEN_WIDTH = 800;
 
-// Paddle
+// Paddle, its column is fixed at PADDLE_X
+const int PADDLE_X = 25;
 const int PADDLE_WIDTH = 10;
 const int PADDLE_HEIGHT = 100;
 const int PADDLE_SPEED = 7;
@@ -41,4 +42,7 @@ const int PADDLE_SPEED = 7;
 const int BALL_SIZE = 10;
 const int BALL_SPEED = 6;
 
+// Simulation steps per second, the speeds above are per step
+const int SIMULATION_HZ = 60;
+
 #endif
\ No newline at end of file
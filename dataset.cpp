@@ -0,0 +1,278 @@
+#include "dataset.h"
+#include "mapped-file.h"
+#include "config.h"
+#include "pong-sim.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+// Round a byte offset up to the column alignment
+static uint64_t align_offset(uint64_t offset)
+{
+    return (offset + WEIGHT_ALIGNMENT - 1) / WEIGHT_ALIGNMENT * WEIGHT_ALIGNMENT;
+}
+
+// Labels are the network's output indices, MOVE_DOWN to MOVE_NONE
+const int MOVE_COUNT = MOVE_NONE + 1;
+
+// Scan an optionally negative decimal integer, advancing pos. Returns false
+// if no digits were found.
+static inline bool scan_int(const char*& pos, const char* end, int& value)
+{
+    bool negative = false;
+    if (pos < end && *pos == '-')
+    {
+        negative = true;
+        ++pos;
+    }
+
+    const char* start = pos;
+    int result = 0;
+    while (pos < end && static_cast<unsigned>(*pos - '0') < 10)
+    {
+        result = result * 10 + (*pos - '0');
+        ++pos;
+    }
+
+    value = negative ? -result : result;
+    return pos != start;
+}
+
+// Skip to the start of the next line
+static inline void skip_line(const char*& pos, const char* end)
+{
+    const void* newline = std::memchr(pos, '\n', end - pos);
+    pos = newline ? static_cast<const char*>(newline) + 1 : end;
+}
+
+
+
+// Loading ----------------------------------------------------------------
+
+bool TrainingDataset::load(const std::string& filename)
+{
+    auto file = std::make_shared<MappedFile>();
+    if (!file->open(filename))
+    {
+        return false;
+    }
+
+    bool loaded;
+    if (file->size() >= sizeof(DatasetFileHeader) &&
+        std::memcmp(file->data(), DATASET_FILE_MAGIC, sizeof(DATASET_FILE_MAGIC)) == 0)
+    {
+        loaded = map_binary(filename, file);
+    }
+    else
+    {
+        loaded = parse_csv(filename, *file);
+    }
+
+    if (loaded)
+    {
+        std::cout << "Read " << count << " game states" << std::endl;
+    }
+    return loaded;
+}
+
+// Single pass over the mapped text straight into the columns
+bool TrainingDataset::parse_csv(const std::string& filename, const MappedFile& file)
+{
+    const char* pos = file.data();
+    const char* end = pos + file.size();
+
+    // Skip header
+    if (pos < end && *pos != '-' && static_cast<unsigned>(*pos - '0') >= 10)
+    {
+        skip_line(pos, end);
+    }
+
+    // Rows are short, so this reserves close to the real count up front
+    size_t estimate = file.size() / 8 + 1;
+    bally_column.clear();
+    paddley_column.clear();
+    move_column.clear();
+    bally_column.reserve(estimate);
+    paddley_column.reserve(estimate);
+    move_column.reserve(estimate);
+
+    size_t line = 1;
+    while (pos < end)
+    {
+        ++line;
+        int bally, paddley, move;
+        if (*pos == '\n' || *pos == '\r')
+        {
+            skip_line(pos, end);
+            continue;
+        }
+
+        if (!scan_int(pos, end, bally) || pos >= end || *pos++ != ',' ||
+            !scan_int(pos, end, paddley) || pos >= end || *pos++ != ',' ||
+            !scan_int(pos, end, move))
+        {
+            std::cerr << "Malformed row " << line << " in " << filename << std::endl;
+            return false;
+        }
+        if (move < 0 || move >= MOVE_COUNT)
+        {
+            std::cerr << "Invalid move " << move << " in row " << line << " of " << filename << std::endl;
+            return false;
+        }
+        skip_line(pos, end);
+
+        bally_column.push_back(bally);
+        paddley_column.push_back(paddley);
+        move_column.push_back(move);
+    }
+
+    mapped_file.reset();
+    bally_data = bally_column.data();
+    paddley_data = paddley_column.data();
+    move_data = move_column.data();
+    count = bally_column.size();
+    return true;
+}
+
+// Point the columns into the mapped file
+bool TrainingDataset::map_binary(const std::string& filename, std::shared_ptr<const MappedFile> file)
+{
+    DatasetFileHeader header;
+    std::memcpy(&header, file->data(), sizeof(header));
+
+    // Bound the count by the bytes after each offset before multiplying,
+    // so a crafted count or offset cannot wrap past the size check
+    bool valid = header.version == DATASET_FILE_VERSION;
+    for (uint64_t offset : {header.bally_offset, header.paddley_offset, header.move_offset})
+    {
+        valid = valid && offset % alignof(int32_t) == 0 && offset <= file->size() &&
+                header.count <= (file->size() - offset) / sizeof(int32_t);
+    }
+    if (!valid)
+    {
+        std::cerr << "Corrupt or unsupported dataset file: " << filename << std::endl;
+        return false;
+    }
+
+    // Training indexes the output layer with the label, so every one is checked
+    const int* moves = reinterpret_cast<const int*>(file->data() + header.move_offset);
+    for (uint64_t i = 0; i < header.count; ++i)
+    {
+        if (moves[i] < 0 || moves[i] >= MOVE_COUNT)
+        {
+            std::cerr << "Invalid move " << moves[i] << " in row " << i << " of " << filename << std::endl;
+            return false;
+        }
+    }
+
+    bally_column.clear();
+    paddley_column.clear();
+    move_column.clear();
+
+    bally_data = reinterpret_cast<const int*>(file->data() + header.bally_offset);
+    paddley_data = reinterpret_cast<const int*>(file->data() + header.paddley_offset);
+    move_data = reinterpret_cast<const int*>(file->data() + header.move_offset);
+    count = header.count;
+    mapped_file = std::move(file);
+    return true;
+}
+
+bool TrainingDataset::write_binary(const std::string& filename) const
+{
+    DatasetFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, DATASET_FILE_MAGIC, sizeof(header.magic));
+    header.version = DATASET_FILE_VERSION;
+    header.count = count;
+
+    uint64_t column_bytes = count * sizeof(int32_t);
+    header.bally_offset = align_offset(sizeof(header));
+    header.paddley_offset = align_offset(header.bally_offset + column_bytes);
+    header.move_offset = align_offset(header.paddley_offset + column_bytes);
+
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        std::cerr << "Error opening file: " << filename << std::endl;
+        return false;
+    }
+
+    // Write each column after zero padding up to its offset
+    uint64_t written = 0;
+    auto write_at = [&](uint64_t offset, const void* data, uint64_t bytes) {
+        static const char zeros[WEIGHT_ALIGNMENT] = {};
+        file.write(zeros, offset - written);
+        file.write(static_cast<const char*>(data), bytes);
+        written = offset + bytes;
+    };
+    write_at(0, &header, sizeof(header));
+    write_at(header.bally_offset, bally_data, column_bytes);
+    write_at(header.paddley_offset, paddley_data, column_bytes);
+    write_at(header.move_offset, move_data, column_bytes);
+
+    if (!file)
+    {
+        std::cerr << "Error writing dataset file: " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+TrainingView TrainingDataset::view() const
+{
+    TrainingView view;
+    view.bally = bally_data;
+    view.paddley = paddley_data;
+    view.moves = move_data;
+    view.state_stride = 1;
+    view.size = count;
+    return view;
+}
+
+// Statistics --------------------------------------------------------------
+
+DatasetStats compute_dataset_stats(const TrainingView& data)
+{
+    DatasetStats stats;
+    stats.count = data.size;
+    if (data.size == 0)
+    {
+        return stats;
+    }
+
+    stats.min_bally = stats.max_bally = data.bally_at(0);
+    stats.min_paddley = stats.max_paddley = data.paddley_at(0);
+
+    double total_margin = 0.0;
+    for (size_t i = 0; i < data.size; ++i)
+    {
+        int bally = data.bally_at(i);
+        int paddley = data.paddley_at(i);
+        if (data.moves[i] >= 0 && data.moves[i] < MOVE_COUNT)
+        {
+            ++stats.move_counts[data.moves[i]];
+        }
+
+        int margin = std::abs(bally - paddley - PADDLE_HEIGHT / 2);
+        total_margin += margin;
+        stats.near_boundary += margin <= DatasetStats::NEAR_MARGIN;
+
+        stats.min_bally = std::min(stats.min_bally, bally);
+        stats.max_bally = std::max(stats.max_bally, bally);
+        stats.min_paddley = std::min(stats.min_paddley, paddley);
+        stats.max_paddley = std::max(stats.max_paddley, paddley);
+    }
+    stats.mean_abs_margin = total_margin / data.size;
+    return stats;
+}
+
+void print_dataset_stats(const DatasetStats& stats, std::ostream& out)
+{
+    double near_share = stats.count > 0 ? 100.0 * stats.near_boundary / stats.count : 0.0;
+    out << "Dataset: " << stats.count << " states - down/up/none: " << stats.move_counts[0] << "/" << stats.move_counts[1] << "/" << stats.move_counts[2]
+        << " - within " << DatasetStats::NEAR_MARGIN << "px of the boundary: " << stats.near_boundary << " (" << near_share << "%)"
+        << " - mean margin: " << stats.mean_abs_margin << "px"
+        << " - ball y " << stats.min_bally << ".." << stats.max_bally << ", paddle y " << stats.min_paddley << ".." << stats.max_paddley << "\n";
+}
@@ -0,0 +1,95 @@
+#ifndef PONG_DATASET_H
+#define PONG_DATASET_H
+
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include "dense-kernels.h"
+#include "network.h"
+
+class MappedFile;
+
+// Packed binary dataset layout (native byte order):
+//
+//   DatasetFileHeader
+//   int32 bally[count], int32 paddley[count], int32 optimalmove[count]
+//
+// Each column starts at a WEIGHT_ALIGNMENT aligned offset and is used in
+// place from the mapped file.
+
+const char DATASET_FILE_MAGIC[8] = {'P', 'O', 'N', 'G', 'D', 'A', 'T', '\0'};
+const uint32_t DATASET_FILE_VERSION = 1;
+
+struct DatasetFileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t count;
+
+    // Byte offsets of the three columns
+    uint64_t bally_offset;
+    uint64_t paddley_offset;
+    uint64_t move_offset;
+};
+
+// Training samples stored as three contiguous int columns. CSV files are
+// memory mapped and scanned in one pass, packed binary files are used
+// straight from the mapping.
+class TrainingDataset
+{
+private:
+    // Parsed columns (CSV input)
+    AlignedVector<int> bally_column;
+    AlignedVector<int> paddley_column;
+    AlignedVector<int> move_column;
+
+    // Column pointers, into the vectors above or into a mapped binary file
+    std::shared_ptr<const MappedFile> mapped_file;
+    const int* bally_data = nullptr;
+    const int* paddley_data = nullptr;
+    const int* move_data = nullptr;
+    size_t count = 0;
+
+    bool parse_csv(const std::string& filename, const MappedFile& file);
+    bool map_binary(const std::string& filename, std::shared_ptr<const MappedFile> file);
+
+public:
+    // Load a CSV (bally,paddley,optimalmove) or packed binary dataset
+    bool load(const std::string& filename);
+
+    // Write the packed binary companion format
+    bool write_binary(const std::string& filename) const;
+
+    size_t size() const { return count; }
+    const int* bally() const { return bally_data; }
+    const int* paddley() const { return paddley_data; }
+    const int* moves() const { return move_data; }
+
+    // View for PongNeuralNetwork::train, valid while the dataset lives
+    TrainingView view() const;
+};
+
+// Make-up of a training set. The margin of a state is its signed distance
+// in pixels from the boundary calculate_movement splits on
+// (bally - paddley - PADDLE_HEIGHT / 2).
+struct DatasetStats
+{
+    // States within this many pixels of the boundary count as near it
+    static const int NEAR_MARGIN = 10;
+
+    size_t count = 0;
+    size_t move_counts[3] = {0, 0, 0};  // MOVE_DOWN, MOVE_UP, MOVE_NONE
+    size_t near_boundary = 0;
+    double mean_abs_margin = 0.0;
+    int min_bally = 0, max_bally = 0;
+    int min_paddley = 0, max_paddley = 0;
+};
+
+DatasetStats compute_dataset_stats(const TrainingView& data);
+
+// Human readable summary of a training set
+void print_dataset_stats(const DatasetStats& stats, std::ostream& out);
+
+#endif
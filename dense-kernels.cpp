@@ -0,0 +1,391 @@
+#include "dense-kernels.h"
+#include <algorithm>
+
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#define PONG_SIMD_AVX2
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define PONG_SIMD_SSE2
+#endif
+
+// Vector primitives ----------------------------------------------------
+
+// Dot product of two contiguous rows
+static inline double dot(const double* a, const double* b, int n)
+{
+    int i = 0;
+    double sum = 0.0;
+
+#if defined(PONG_SIMD_AVX2)
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    for (; i + 8 <= n; i += 8)
+    {
+        acc0 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i), acc0);
+        acc1 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i + 4), _mm256_loadu_pd(b + i + 4), acc1);
+    }
+    for (; i + 4 <= n; i += 4)
+    {
+        acc0 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i), acc0);
+    }
+    acc0 = _mm256_add_pd(acc0, acc1);
+    __m128d half = _mm_add_pd(_mm256_castpd256_pd128(acc0), _mm256_extractf128_pd(acc0, 1));
+    sum = _mm_cvtsd_f64(_mm_add_sd(half, _mm_unpackhi_pd(half, half)));
+#elif defined(PONG_SIMD_SSE2)
+    __m128d acc = _mm_setzero_pd();
+    for (; i + 2 <= n; i += 2)
+    {
+        acc = _mm_add_pd(acc, _mm_mul_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+    }
+    sum = _mm_cvtsd_f64(_mm_add_sd(acc, _mm_unpackhi_pd(acc, acc)));
+#endif
+
+    // Scalar tail (and the whole row without SIMD)
+    for (; i < n; ++i)
+    {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+static inline float dot(const float* a, const float* b, int n)
+{
+    int i = 0;
+    float sum = 0.0f;
+
+#if defined(PONG_SIMD_AVX2)
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    for (; i + 16 <= n; i += 16)
+    {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8), acc1);
+    }
+    for (; i + 8 <= n; i += 8)
+    {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+    }
+    acc0 = _mm256_add_ps(acc0, acc1);
+    __m128 half = _mm_add_ps(_mm256_castps256_ps128(acc0), _mm256_extractf128_ps(acc0, 1));
+    half = _mm_add_ps(half, _mm_movehl_ps(half, half));
+    sum = _mm_cvtss_f32(_mm_add_ss(half, _mm_shuffle_ps(half, half, 1)));
+#elif defined(PONG_SIMD_SSE2)
+    __m128 acc = _mm_setzero_ps();
+    for (; i + 4 <= n; i += 4)
+    {
+        acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    }
+    acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+    sum = _mm_cvtss_f32(_mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 1)));
+#endif
+
+    for (; i < n; ++i)
+    {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+// y += alpha * x
+static inline void axpy(double alpha, const double* x, double* y, std::size_t n)
+{
+    std::size_t i = 0;
+
+#if defined(PONG_SIMD_AVX2)
+    __m256d a = _mm256_set1_pd(alpha);
+    for (; i + 4 <= n; i += 4)
+    {
+        _mm256_storeu_pd(y + i, _mm256_fmadd_pd(a, _mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+    }
+#elif defined(PONG_SIMD_SSE2)
+    __m128d a = _mm_set1_pd(alpha);
+    for (; i + 2 <= n; i += 2)
+    {
+        _mm_storeu_pd(y + i, _mm_add_pd(_mm_loadu_pd(y + i), _mm_mul_pd(a, _mm_loadu_pd(x + i))));
+    }
+#endif
+
+    for (; i < n; ++i)
+    {
+        y[i] += alpha * x[i];
+    }
+}
+
+static inline void axpy(float alpha, const float* x, float* y, std::size_t n)
+{
+    std::size_t i = 0;
+
+#if defined(PONG_SIMD_AVX2)
+    __m256 a = _mm256_set1_ps(alpha);
+    for (; i + 8 <= n; i += 8)
+    {
+        _mm256_storeu_ps(y + i, _mm256_fmadd_ps(a, _mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i)));
+    }
+#elif defined(PONG_SIMD_SSE2)
+    __m128 a = _mm_set1_ps(alpha);
+    for (; i + 4 <= n; i += 4)
+    {
+        _mm_storeu_ps(y + i, _mm_add_ps(_mm_loadu_ps(y + i), _mm_mul_ps(a, _mm_loadu_ps(x + i))));
+    }
+#endif
+
+    for (; i < n; ++i)
+    {
+        y[i] += alpha * x[i];
+    }
+}
+
+// Four dot products of one weight row against four input rows
+static inline void dot4(const double* w, const double* x0, const double* x1, const double* x2, const double* x3,
+                        int n, double* out)
+{
+    int i = 0;
+    double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+
+#if defined(PONG_SIMD_AVX2)
+    __m256d a0 = _mm256_setzero_pd(), a1 = _mm256_setzero_pd();
+    __m256d a2 = _mm256_setzero_pd(), a3 = _mm256_setzero_pd();
+    for (; i + 4 <= n; i += 4)
+    {
+        __m256d wv = _mm256_loadu_pd(w + i);
+        a0 = _mm256_fmadd_pd(wv, _mm256_loadu_pd(x0 + i), a0);
+        a1 = _mm256_fmadd_pd(wv, _mm256_loadu_pd(x1 + i), a1);
+        a2 = _mm256_fmadd_pd(wv, _mm256_loadu_pd(x2 + i), a2);
+        a3 = _mm256_fmadd_pd(wv, _mm256_loadu_pd(x3 + i), a3);
+    }
+
+    // Transpose-reduce the four accumulators into one vector of sums
+    __m256d t01 = _mm256_hadd_pd(a0, a1);
+    __m256d t23 = _mm256_hadd_pd(a2, a3);
+    __m256d lo = _mm256_permute2f128_pd(t01, t23, 0x20);
+    __m256d hi = _mm256_permute2f128_pd(t01, t23, 0x31);
+    alignas(32) double sums[4];
+    _mm256_store_pd(sums, _mm256_add_pd(lo, hi));
+    s0 = sums[0]; s1 = sums[1]; s2 = sums[2]; s3 = sums[3];
+#endif
+
+    for (; i < n; ++i)
+    {
+        s0 += w[i] * x0[i];
+        s1 += w[i] * x1[i];
+        s2 += w[i] * x2[i];
+        s3 += w[i] * x3[i];
+    }
+
+    out[0] = s0; out[1] = s1; out[2] = s2; out[3] = s3;
+}
+
+static inline void dot4(const float* w, const float* x0, const float* x1, const float* x2, const float* x3,
+                        int n, float* out)
+{
+    int i = 0;
+    float s0 = 0.0f, s1 = 0.0f, s2 = 0.0f, s3 = 0.0f;
+
+#if defined(PONG_SIMD_AVX2)
+    __m256 a0 = _mm256_setzero_ps(), a1 = _mm256_setzero_ps();
+    __m256 a2 = _mm256_setzero_ps(), a3 = _mm256_setzero_ps();
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256 wv = _mm256_loadu_ps(w + i);
+        a0 = _mm256_fmadd_ps(wv, _mm256_loadu_ps(x0 + i), a0);
+        a1 = _mm256_fmadd_ps(wv, _mm256_loadu_ps(x1 + i), a1);
+        a2 = _mm256_fmadd_ps(wv, _mm256_loadu_ps(x2 + i), a2);
+        a3 = _mm256_fmadd_ps(wv, _mm256_loadu_ps(x3 + i), a3);
+    }
+
+    // Pairwise horizontal adds leave the four sums in one 128-bit lane
+    __m256 t01 = _mm256_hadd_ps(a0, a1);
+    __m256 t23 = _mm256_hadd_ps(a2, a3);
+    __m256 t = _mm256_hadd_ps(t01, t23);
+    __m128 total = _mm_add_ps(_mm256_castps256_ps128(t), _mm256_extractf128_ps(t, 1));
+    alignas(16) float sums[4];
+    _mm_store_ps(sums, total);
+    s0 = sums[0]; s1 = sums[1]; s2 = sums[2]; s3 = sums[3];
+#endif
+
+    for (; i < n; ++i)
+    {
+        s0 += w[i] * x0[i];
+        s1 += w[i] * x1[i];
+        s2 += w[i] * x2[i];
+        s3 += w[i] * x3[i];
+    }
+
+    out[0] = s0; out[1] = s1; out[2] = s2; out[3] = s3;
+}
+
+
+
+// Dense layer kernels --------------------------------------------------
+
+template <typename T>
+void dense_forward(const T* weights, const T* biases, const T* input, T* output, int rows, int cols)
+{
+    for (int j = 0; j < rows; ++j)
+    {
+        output[j] = dot(weights + static_cast<std::size_t>(j) * cols, input, cols) + biases[j];
+    }
+}
+
+template <typename T>
+void dense_backward(const T* weights, const T* delta, T* output, int rows, int cols)
+{
+    for (int k = 0; k < cols; ++k)
+    {
+        output[k] = T(0);
+    }
+
+    // Accumulate row by row so the weight matrix is streamed in storage order
+    for (int j = 0; j < rows; ++j)
+    {
+        axpy(delta[j], weights + static_cast<std::size_t>(j) * cols, output, cols);
+    }
+}
+
+template <typename T>
+void dense_update(T* weights, T* biases, const T* delta, const T* input, T learning_rate, int rows, int cols)
+{
+    for (int j = 0; j < rows; ++j)
+    {
+        T step = -learning_rate * delta[j];
+        axpy(step, input, weights + static_cast<std::size_t>(j) * cols, cols);
+        biases[j] += step;
+    }
+}
+
+
+
+// Batched kernels ------------------------------------------------------
+
+// Samples handled together so each weight row is loaded once per tile
+const int BATCH_TILE = 4;
+
+template <typename T>
+void dense_forward_batch(const T* weights, const T* biases, const T* input, T* output, int batch, int rows, int cols)
+{
+    int n = 0;
+    for (; n + BATCH_TILE <= batch; n += BATCH_TILE)
+    {
+        const T* x = input + static_cast<std::size_t>(n) * cols;
+        T* y = output + static_cast<std::size_t>(n) * rows;
+        T sums[BATCH_TILE];
+
+        for (int j = 0; j < rows; ++j)
+        {
+            dot4(weights + static_cast<std::size_t>(j) * cols, x, x + cols, x + 2 * cols, x + 3 * cols, cols, sums);
+            for (int t = 0; t < BATCH_TILE; ++t)
+            {
+                y[static_cast<std::size_t>(t) * rows + j] = sums[t] + biases[j];
+            }
+        }
+    }
+
+    // Leftover samples go through the single vector kernel
+    for (; n < batch; ++n)
+    {
+        dense_forward(weights, biases, input + static_cast<std::size_t>(n) * cols, output + static_cast<std::size_t>(n) * rows, rows, cols);
+    }
+}
+
+template <typename T>
+void dense_backward_batch(const T* weights, const T* delta, T* output, int batch, int rows, int cols)
+{
+    for (int n = 0; n < batch; n += BATCH_TILE)
+    {
+        int tile = std::min(BATCH_TILE, batch - n);
+        for (int t = 0; t < tile; ++t)
+        {
+            T* out = output + static_cast<std::size_t>(n + t) * cols;
+            for (int k = 0; k < cols; ++k)
+            {
+                out[k] = T(0);
+            }
+        }
+
+        // Stream each weight row once for the whole tile
+        for (int j = 0; j < rows; ++j)
+        {
+            const T* w = weights + static_cast<std::size_t>(j) * cols;
+            for (int t = 0; t < tile; ++t)
+            {
+                axpy(delta[static_cast<std::size_t>(n + t) * rows + j], w, output + static_cast<std::size_t>(n + t) * cols, cols);
+            }
+        }
+    }
+}
+
+template <typename T>
+void dense_gradient_batch(const T* delta, const T* input, T* weight_grad, T* bias_grad, int batch, int rows, int cols)
+{
+    // Each gradient row stays in cache while the batch streams past it
+    for (int j = 0; j < rows; ++j)
+    {
+        T* g = weight_grad + static_cast<std::size_t>(j) * cols;
+        T bias_sum = T(0);
+        for (int n = 0; n < batch; ++n)
+        {
+            T d = delta[static_cast<std::size_t>(n) * rows + j];
+            axpy(d, input + static_cast<std::size_t>(n) * cols, g, cols);
+            bias_sum += d;
+        }
+        bias_grad[j] += bias_sum;
+    }
+}
+
+template <typename T>
+void scaled_add(T alpha, const T* x, T* y, std::size_t n)
+{
+    axpy(alpha, x, y, n);
+}
+
+
+
+// Quantized kernels ----------------------------------------------------
+
+void dense_forward_int8(const std::int8_t* weights, const std::int32_t* biases, const std::int8_t* input, std::int32_t* output, int rows, int stride)
+{
+    for (int j = 0; j < rows; ++j)
+    {
+        const std::int8_t* w = weights + static_cast<std::size_t>(j) * stride;
+        std::int32_t sum = 0;
+        int k = 0;
+
+#if defined(PONG_SIMD_AVX2)
+        // Widen 16 int8 pairs to int16 and let madd sum adjacent products into int32
+        __m256i acc = _mm256_setzero_si256();
+        for (; k + 16 <= stride; k += 16)
+        {
+            __m256i wv = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(w + k)));
+            __m256i xv = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input + k)));
+            acc = _mm256_add_epi32(acc, _mm256_madd_epi16(wv, xv));
+        }
+        __m128i half = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+        half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0x4e));
+        half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0xb1));
+        sum = _mm_cvtsi128_si32(half);
+#endif
+
+        for (; k < stride; ++k)
+        {
+            sum += static_cast<std::int32_t>(w[k]) * static_cast<std::int32_t>(input[k]);
+        }
+        output[j] = sum + biases[j];
+    }
+}
+
+// Instantiations ---------------------------------------------------------
+
+#define PONG_DENSE_KERNELS(T) \
+    template void dense_forward<T>(const T*, const T*, const T*, T*, int, int); \
+    template void dense_backward<T>(const T*, const T*, T*, int, int); \
+    template void dense_update<T>(T*, T*, const T*, const T*, T, int, int); \
+    template void dense_forward_batch<T>(const T*, const T*, const T*, T*, int, int, int); \
+    template void dense_backward_batch<T>(const T*, const T*, T*, int, int, int); \
+    template void dense_gradient_batch<T>(const T*, const T*, T*, T*, int, int, int); \
+    template void scaled_add<T>(T, const T*, T*, std::size_t);
+
+PONG_DENSE_KERNELS(float)
+PONG_DENSE_KERNELS(double)
+
+#undef PONG_DENSE_KERNELS
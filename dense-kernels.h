@@ -0,0 +1,93 @@
+#ifndef PONG_DENSE_KERNELS_H
+#define PONG_DENSE_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+// Alignment of every weight block (one cache line, wide enough for AVX-512 loads)
+const std::size_t WEIGHT_ALIGNMENT = 64;
+
+// Allocator handing out WEIGHT_ALIGNMENT aligned blocks
+template <typename T>
+struct AlignedAllocator
+{
+    using value_type = T;
+
+    AlignedAllocator() = default;
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U>&) {}
+
+    T* allocate(std::size_t n)
+    {
+        // aligned_alloc needs the size to be a multiple of the alignment
+        std::size_t bytes = (n * sizeof(T) + WEIGHT_ALIGNMENT - 1) / WEIGHT_ALIGNMENT * WEIGHT_ALIGNMENT;
+        void* ptr = std::aligned_alloc(WEIGHT_ALIGNMENT, bytes);
+        if (!ptr)
+        {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(ptr);
+    }
+
+    void deallocate(T* ptr, std::size_t) { std::free(ptr); }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U>&) const { return true; }
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U>&) const { return false; }
+};
+
+template <typename T>
+using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+
+// Number of elements to pad a block of n values to so the next block stays aligned
+template <typename T>
+constexpr std::size_t aligned_size(std::size_t n)
+{
+    const std::size_t per_line = WEIGHT_ALIGNMENT / sizeof(T);
+    return (n + per_line - 1) / per_line * per_line;
+}
+
+// Dense layer kernels over a row-major (rows x cols) weight matrix. Each
+// kernel is instantiated for float and double.
+
+// output = weights * input + biases
+template <typename T>
+void dense_forward(const T* weights, const T* biases, const T* input, T* output, int rows, int cols);
+
+// output = transpose(weights) * delta
+template <typename T>
+void dense_backward(const T* weights, const T* delta, T* output, int rows, int cols);
+
+// weights -= learning_rate * delta * transpose(input), biases -= learning_rate * delta
+template <typename T>
+void dense_update(T* weights, T* biases, const T* delta, const T* input, T learning_rate, int rows, int cols);
+
+// Batched kernels, activations are row-major (batch x width) matrices
+
+// output = input * transpose(weights) + biases, for every sample in the batch
+template <typename T>
+void dense_forward_batch(const T* weights, const T* biases, const T* input, T* output, int batch, int rows, int cols);
+
+// output = delta * weights, maps (batch x rows) deltas back to (batch x cols)
+template <typename T>
+void dense_backward_batch(const T* weights, const T* delta, T* output, int batch, int rows, int cols);
+
+// weight_grad += transpose(delta) * input, bias_grad += column sums of delta
+template <typename T>
+void dense_gradient_batch(const T* delta, const T* input, T* weight_grad, T* bias_grad, int batch, int rows, int cols);
+
+// y += alpha * x over a whole buffer
+template <typename T>
+void scaled_add(T alpha, const T* x, T* y, std::size_t n);
+
+// Quantized kernel, int8 weights and inputs with int32 accumulation.
+// stride is the padded row length and must be a multiple of 16.
+
+// output = weights * input + biases
+void dense_forward_int8(const std::int8_t* weights, const std::int32_t* biases, const std::int8_t* input, std::int32_t* output, int rows, int stride);
+
+#endif
@@ -0,0 +1,200 @@
+#include "evolution.h"
+#include "pong-sim.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <limits>
+#include <numeric>
+
+// Setup -------------------------------------------------------------------
+
+NeuroEvolution::NeuroEvolution(const PongNeuralNetwork& seed, const EvolutionOptions& evolution_options)
+    : options(evolution_options),
+    layout(seed),
+    stride(seed.get_parameter_count()),
+    best_score(-std::numeric_limits<double>::infinity()),
+    generations(0),
+    pool(evolution_options.num_threads),
+    gen(evolution_options.seed)
+{
+    options.population = std::max(2, options.population);
+    options.elites = std::min(std::max(0, options.elites), options.population - 1);
+    options.tournament = std::max(1, options.tournament);
+
+    layout.enable_policy_table(false);
+
+    const double* base = seed.get_parameters();
+    for (size_t layer = 0; layer + 1 < seed.get_layer_sizes().size(); ++layer)
+    {
+        size_t inputs = seed.get_layer_sizes()[layer];
+        size_t outputs = seed.get_layer_sizes()[layer + 1];
+        segments.emplace_back(seed.get_layer_weights(layer) - base, inputs * outputs);
+        segments.emplace_back(seed.get_layer_biases(layer) - base, outputs);
+    }
+
+    // First generation: the seed itself, then noisy copies of it
+    population.assign(stride * options.population, 0.0);
+    offspring.assign(stride * options.population, 0.0);
+    fitness.assign(options.population, 0.0);
+
+    std::normal_distribution<double> noise(0.0, options.initial_sigma);
+    for (int i = 0; i < options.population; ++i)
+    {
+        double* values = individual(population, i);
+        std::copy_n(base, stride, values);
+        if (i == 0)
+        {
+            continue;
+        }
+        for (const auto& segment : segments)
+        {
+            for (size_t j = segment.first; j < segment.first + segment.second; ++j)
+            {
+                values[j] += noise(gen);
+            }
+        }
+    }
+
+    // From here on the layout never owns weights
+    layout.view_parameters(population.data());
+}
+
+// Scoring -----------------------------------------------------------------
+
+double NeuroEvolution::play_fitness(const PongNeuralNetwork& network, long ticks)
+{
+    PongNeuralNetwork::Workspace workspace;
+    network.prepare_workspace(workspace);
+
+    PongSimulation sim;
+    long level = 0;
+    for (long t = 0; t < ticks; ++t)
+    {
+        sim.step(network.predict_move(sim.state(), workspace));
+
+        const Rect& ball = sim.get_ball();
+        const Rect& paddle = sim.get_paddle();
+        int ball_centre = ball.y + ball.h / 2;
+        level += ball_centre >= paddle.y && ball_centre < paddle.y + paddle.h;
+    }
+
+    return static_cast<double>(sim.get_hits() - sim.get_misses()) + static_cast<double>(level) / std::max(1L, ticks);
+}
+
+void NeuroEvolution::evaluate()
+{
+    pool.parallel_for(options.population, [&](int i) {
+        PongNeuralNetwork network(layout);
+        network.view_parameters(individual(population, i));
+        fitness[i] = play_fitness(network, options.play_ticks);
+    });
+
+    int fittest = static_cast<int>(std::max_element(fitness.begin(), fitness.end()) - fitness.begin());
+    if (fitness[fittest] > best_score)
+    {
+        best_score = fitness[fittest];
+        const double* values = individual(population, fittest);
+        best_parameters.assign(values, values + stride);
+    }
+}
+
+// Breeding ----------------------------------------------------------------
+
+int NeuroEvolution::select_parent()
+{
+    std::uniform_int_distribution<int> pick(0, options.population - 1);
+    int winner = pick(gen);
+    for (int round = 1; round < options.tournament; ++round)
+    {
+        int challenger = pick(gen);
+        if (fitness[challenger] > fitness[winner])
+        {
+            winner = challenger;
+        }
+    }
+    return winner;
+}
+
+void NeuroEvolution::breed()
+{
+    std::vector<int> ranking(options.population);
+    std::iota(ranking.begin(), ranking.end(), 0);
+    std::stable_sort(ranking.begin(), ranking.end(), [&](int a, int b) { return fitness[a] > fitness[b]; });
+
+    for (int i = 0; i < options.elites; ++i)
+    {
+        std::copy_n(individual(population, ranking[i]), stride, individual(offspring, i));
+    }
+
+    std::uniform_real_distribution<double> chance(0.0, 1.0);
+    std::normal_distribution<double> noise(0.0, options.mutation_sigma);
+    for (int i = options.elites; i < options.population; ++i)
+    {
+        double* child = individual(offspring, i);
+        std::copy_n(individual(population, select_parent()), stride, child);
+
+        const double* other = chance(gen) < options.crossover_rate ? individual(population, select_parent()) : nullptr;
+        for (const auto& segment : segments)
+        {
+            for (size_t j = segment.first; j < segment.first + segment.second; ++j)
+            {
+                if (other && chance(gen) < 0.5)
+                {
+                    child[j] = other[j];
+                }
+                if (chance(gen) < options.mutation_rate)
+                {
+                    child[j] += noise(gen);
+                }
+            }
+        }
+    }
+
+    population.swap(offspring);
+    layout.view_parameters(population.data());
+}
+
+// Public ------------------------------------------------------------------
+
+GenerationStats NeuroEvolution::step()
+{
+    auto start = std::chrono::steady_clock::now();
+    evaluate();
+
+    GenerationStats stats;
+    stats.generation = ++generations;
+    stats.best_fitness = *std::max_element(fitness.begin(), fitness.end());
+    stats.mean_fitness = std::accumulate(fitness.begin(), fitness.end(), 0.0) / options.population;
+
+    breed();
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    stats.evaluations_per_second = stats.seconds > 0.0 ? options.population / stats.seconds : 0.0;
+
+    if (options.verbose)
+    {
+        std::cout << "Generation " << stats.generation << " - Best: " << stats.best_fitness << " - Mean: " << stats.mean_fitness
+                  << " - Evaluations/s: " << static_cast<long>(stats.evaluations_per_second) << " (" << pool.size() << " threads)\n";
+    }
+    return stats;
+}
+
+std::vector<GenerationStats> NeuroEvolution::run(int generation_count)
+{
+    std::vector<GenerationStats> history;
+    for (int g = 0; g < generation_count; ++g)
+    {
+        history.push_back(step());
+    }
+    if (options.verbose)
+    {
+        std::cout.flush();
+    }
+    return history;
+}
+
+PongNeuralNetwork NeuroEvolution::best() const
+{
+    PongNeuralNetwork network(layout);
+    network.set_parameters(best_parameters.empty() ? layout.get_parameters() : best_parameters.data());
+    return network;
+}
@@ -0,0 +1,121 @@
+#ifndef PONG_EVOLUTION_H
+#define PONG_EVOLUTION_H
+
+#include <random>
+#include <utility>
+#include <vector>
+#include "dense-kernels.h"
+#include "network.h"
+#include "thread-pool.h"
+
+// Knobs for evolve beyond the seed network
+struct EvolutionOptions
+{
+    int population = 64;
+
+    // Best individuals carried into the next generation unchanged
+    int elites = 4;
+
+    // Individuals compared when picking each parent
+    int tournament = 3;
+
+    // Chance a child mixes two parents parameter by parameter
+    double crossover_rate = 0.5;
+
+    // Share of a child's parameters that get gaussian noise, and its spread
+    double mutation_rate = 0.1;
+    double mutation_sigma = 0.3;
+
+    // Noise added to the seed network to spread the first generation
+    double initial_sigma = 1.0;
+
+    // Headless ticks played to score one individual
+    long play_ticks = 10000;
+
+    // Threads scoring individuals (<= 0 uses all cores)
+    int num_threads = 0;
+
+    unsigned seed = 1;
+
+    // Print one line per generation to std::cout
+    bool verbose = true;
+};
+
+// What one generation scored
+struct GenerationStats
+{
+    int generation = 0;  // 1 based
+    double best_fitness = 0.0;
+    double mean_fitness = 0.0;
+    double seconds = 0.0;
+    double evaluations_per_second = 0.0;
+};
+
+// Genetic search over network weights, scored by playing the game instead
+// of matching calculate_movement. Fitness is hits minus misses over a
+// headless game, plus the share of ticks the paddle spent level with the
+// ball so early generations that never hit still have a gradient. The
+// simulation always serves the same way, so fitness is deterministic.
+//
+// The whole population lives in one aligned arena of population x
+// get_parameter_count() values, with a second arena the next generation is
+// bred into before the two swap. Scoring an individual copies a network
+// that views its arena slot, so no weights are copied, and individuals are
+// scored in parallel on a ThreadPool.
+class NeuroEvolution
+{
+private:
+    EvolutionOptions options;
+
+    // Architecture, normalization and math mode shared by every individual.
+    // It views the arena, so copying it never copies weights.
+    PongNeuralNetwork layout;
+    size_t stride;
+
+    // [offset, offset + count) ranges holding real weights and biases, the
+    // layout's alignment padding is never mutated
+    std::vector<std::pair<size_t, size_t>> segments;
+
+    AlignedVector<double> population;
+    AlignedVector<double> offspring;
+    std::vector<double> fitness;
+
+    std::vector<double> best_parameters;
+    double best_score;
+    int generations;
+
+    ThreadPool pool;
+    std::mt19937 gen;
+
+    double* individual(AlignedVector<double>& arena, int index) { return arena.data() + static_cast<size_t>(index) * stride; }
+
+    // Score every individual of the current population
+    void evaluate();
+
+    // Index of the fittest of options.tournament random individuals
+    int select_parent();
+
+    // Fill the offspring arena from the scored population and swap them
+    void breed();
+
+public:
+    // seed sets the architecture and input scaling, and is the centre the
+    // first generation is spread around
+    NeuroEvolution(const PongNeuralNetwork& seed, const EvolutionOptions& evolution_options);
+
+    // Score the current population, then breed the next one
+    GenerationStats step();
+
+    // step generation_count times
+    std::vector<GenerationStats> run(int generation_count);
+
+    // Fitness of a single network, the same measure the search uses
+    static double play_fitness(const PongNeuralNetwork& network, long ticks);
+
+    double get_best_fitness() const { return best_score; }
+
+    // Standalone copy of the fittest individual scored so far
+    PongNeuralNetwork best() const;
+};
+
+#endif
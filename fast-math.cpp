@@ -0,0 +1,173 @@
+#include "fast-math.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+// Bit layout needed to build 2^k directly in the exponent field
+template <typename T>
+struct FloatTraits;
+
+template <>
+struct FloatTraits<float>
+{
+    using Bits = uint32_t;
+    static const int MANTISSA_BITS = 23;
+    static constexpr float EXPONENT_BIAS = 127.0f;
+
+    // exp stays a normal float across this range
+    static constexpr float MIN_EXP_ARG = -87.0f;
+    static constexpr float MAX_EXP_ARG = 88.0f;
+
+    // ln2 split so k * LN2_HI is exact for every k in range
+    static constexpr float LN2_HI = 0.693359375f;
+    static constexpr float LN2_LO = -2.12194440e-4f;
+};
+
+template <>
+struct FloatTraits<double>
+{
+    using Bits = uint64_t;
+    static const int MANTISSA_BITS = 52;
+    static constexpr double EXPONENT_BIAS = 1023.0;
+
+    static constexpr double MIN_EXP_ARG = -708.0;
+    static constexpr double MAX_EXP_ARG = 709.0;
+
+    static constexpr double LN2_HI = 6.93147180369123816490e-01;
+    static constexpr double LN2_LO = 1.90821492927058770002e-10;
+};
+
+// tanh ------------------------------------------------------------------
+
+// tanh(x) is 1 to within float rounding past this point
+static const double TANH_CLAMP = 7.90531110763549805;
+
+template <typename T>
+void tanh_inplace(T* values, std::size_t n, MathMode mode)
+{
+    if (mode == MathMode::Exact)
+    {
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            values[i] = std::tanh(values[i]);
+        }
+        return;
+    }
+
+    // x * P(x^2) / Q(x^2), coefficients from a minimax fit of tanh
+    const T a1 = T(4.89352455891786e-03);
+    const T a3 = T(6.37261928875436e-04);
+    const T a5 = T(1.48572235717979e-05);
+    const T a7 = T(5.12229709037114e-08);
+    const T a9 = T(-8.60467152213735e-11);
+    const T a11 = T(2.00018790482477e-13);
+    const T a13 = T(-2.76076847742355e-16);
+    const T b0 = T(4.89352518554385e-03);
+    const T b2 = T(2.26843463243900e-03);
+    const T b4 = T(1.18534705686654e-04);
+    const T b6 = T(1.19825839466702e-06);
+    const T low = T(-TANH_CLAMP);
+    const T high = T(TANH_CLAMP);
+
+#pragma omp simd
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        // Ternaries rather than std::min/max, which take references and
+        // keep the loop from vectorizing
+        T x = values[i];
+        x = x < low ? low : (x > high ? high : x);
+        T x2 = x * x;
+        T p = x * (a1 + x2 * (a3 + x2 * (a5 + x2 * (a7 + x2 * (a9 + x2 * (a11 + x2 * a13))))));
+        T q = b0 + x2 * (b2 + x2 * (b4 + x2 * b6));
+        values[i] = p / q;
+    }
+}
+
+// exp -------------------------------------------------------------------
+
+template <typename T>
+void exp_inplace(T* values, std::size_t n, MathMode mode)
+{
+    if (mode == MathMode::Exact)
+    {
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            values[i] = std::exp(values[i]);
+        }
+        return;
+    }
+
+    using Traits = FloatTraits<T>;
+    using Bits = typename Traits::Bits;
+
+    // Adding 2^MANTISSA_BITS to a small whole number leaves that number in
+    // the low mantissa bits, which a shift then moves into the exponent.
+    // Adding 1.5 * 2^MANTISSA_BITS rounds to the nearest whole number
+    // without std::floor, which GCC will not vectorize here.
+    const T shift = T(Bits(1) << Traits::MANTISSA_BITS);
+    const T round_shift = T(1.5) * shift;
+    const T log2e = T(1.44269504088896340736);
+    const T low = Traits::MIN_EXP_ARG;
+    const T high = Traits::MAX_EXP_ARG;
+
+#pragma omp simd
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        T x = values[i];
+        x = x < low ? low : (x > high ? high : x);
+
+        // x = k ln2 + r, |r| <= ln2/2
+        T k = (x * log2e + round_shift) - round_shift;
+        T r = x - k * Traits::LN2_HI - k * Traits::LN2_LO;
+
+        // exp(r) by its Taylor series, truncation error below 6e-9 here
+        T p = T(1) + r * (T(1) + r * (T(1.0 / 2) + r * (T(1.0 / 6) + r * (T(1.0 / 24) +
+              r * (T(1.0 / 120) + r * (T(1.0 / 720) + r * T(1.0 / 5040)))))));
+
+        // 2^k built in the exponent field. GCC defines type punning through
+        // a union, and unlike memcpy it keeps the loop vectorizable.
+        union
+        {
+            T value;
+            Bits bits;
+        } scale;
+        scale.value = k + Traits::EXPONENT_BIAS + shift;
+        scale.bits <<= Traits::MANTISSA_BITS;
+
+        values[i] = p * scale.value;
+    }
+}
+
+// softmax ---------------------------------------------------------------
+
+template <typename T>
+void softmax_inplace(T* values, int n, MathMode mode)
+{
+    T max_val = *std::max_element(values, values + n);
+    for (int i = 0; i < n; ++i)
+    {
+        values[i] -= max_val;
+    }
+
+    exp_inplace(values, n, mode);
+
+    T exp_sum = 0;
+    for (int i = 0; i < n; ++i)
+    {
+        exp_sum += values[i];
+    }
+    for (int i = 0; i < n; ++i)
+    {
+        values[i] /= exp_sum;
+    }
+}
+
+#define PONG_FAST_MATH(T) \
+    template void tanh_inplace<T>(T*, std::size_t, MathMode); \
+    template void exp_inplace<T>(T*, std::size_t, MathMode); \
+    template void softmax_inplace<T>(T*, int, MathMode);
+
+PONG_FAST_MATH(float)
+PONG_FAST_MATH(double)
+
+#undef PONG_FAST_MATH
@@ -0,0 +1,501 @@
+#ifndef PONG_FIXED_NETWORK_H
+#define PONG_FIXED_NETWORK_H
+
+#include <array>
+#include <chrono>
+#include <utility>
+#include "config.h"
+#include "dense-kernels.h"
+#include "fast-math.h"
+#include "model-file.h"
+#include "network.h"
+#include "training-metrics.h"
+
+// Flat parameter layout shared with BasicPongNeuralNetwork, so both read
+// and write the same model files. Layer i has its weights at
+// fixed_weight_offset(i) and biases at fixed_bias_offset(i), each block
+// padded to the weight alignment. The fixed network keeps each weight
+// block transposed in memory (see the class comment) and converts when it
+// copies or saves.
+
+template <typename Scalar, std::size_t N>
+constexpr std::size_t fixed_weight_offset(const std::array<int, N>& sizes, std::size_t layer)
+{
+    std::size_t offset = 0;
+    for (std::size_t i = 0; i < layer; ++i)
+    {
+        offset += aligned_size<Scalar>(static_cast<std::size_t>(sizes[i + 1]) * sizes[i]);
+        offset += aligned_size<Scalar>(sizes[i + 1]);
+    }
+    return offset;
+}
+
+template <typename Scalar, std::size_t N>
+constexpr std::size_t fixed_bias_offset(const std::array<int, N>& sizes, std::size_t layer)
+{
+    return fixed_weight_offset<Scalar>(sizes, layer) + aligned_size<Scalar>(static_cast<std::size_t>(sizes[layer + 1]) * sizes[layer]);
+}
+
+// Start of layer i's values in one buffer holding every layer back to back
+template <std::size_t N>
+constexpr std::size_t fixed_activation_offset(const std::array<int, N>& sizes, std::size_t layer)
+{
+    std::size_t offset = 0;
+    for (std::size_t i = 0; i < layer; ++i)
+    {
+        offset += sizes[i];
+    }
+    return offset;
+}
+
+// Copy a rows x cols weight block to cols x rows
+template <typename Scalar>
+void transpose_weights(const Scalar* from, Scalar* to, int rows, int cols)
+{
+    for (int j = 0; j < rows; ++j)
+    {
+        for (int k = 0; k < cols; ++k)
+        {
+            to[static_cast<std::size_t>(k) * rows + j] = from[static_cast<std::size_t>(j) * cols + k];
+        }
+    }
+}
+
+// Network whose architecture is a template argument. Every loop bound is
+// a compile time constant and the parameters and activations live inline
+// in std::arrays. Weights are stored transposed, one contiguous run of
+// outputs per input, so the forward pass keeps one output per vector lane
+// in a register across all inputs and the gradient update streams whole
+// output runs. Neither needs the per-output horizontal reduction of a row
+// major dot product, which is what makes small layers cheaper here than in
+// the dense kernels. The backward pass is one fixed length dot product per
+// input.
+// Meant for small production policies: the whole network sits inside the
+// object, so large architectures belong in BasicPongNeuralNetwork.
+//
+// Training and prediction mirror BasicPongNeuralNetwork, including the
+// math mode, and save/load use the same model file format, so models move
+// freely between the two.
+template <typename Scalar, int... Layers>
+class BasicFixedPongNetwork
+{
+public:
+    static constexpr std::size_t NUM_LAYERS = sizeof...(Layers);
+    static_assert(NUM_LAYERS >= 2, "A network needs an input and an output layer");
+    static_assert(((Layers > 0) && ...), "Layer sizes must be positive");
+
+    static constexpr std::array<int, NUM_LAYERS> LAYER_SIZES = {Layers...};
+    static constexpr int INPUTS = LAYER_SIZES[0];
+    static constexpr int OUTPUTS = LAYER_SIZES[NUM_LAYERS - 1];
+    static constexpr std::size_t PARAMETER_COUNT = fixed_weight_offset<Scalar>(LAYER_SIZES, NUM_LAYERS - 1);
+    static constexpr std::size_t ACTIVATION_COUNT = fixed_activation_offset(LAYER_SIZES, NUM_LAYERS);
+
+private:
+    using Activations = std::array<Scalar, ACTIVATION_COUNT>;
+    using LayerIndices = std::make_index_sequence<NUM_LAYERS - 1>;
+    using HiddenIndices = std::make_index_sequence<NUM_LAYERS - 2>;
+
+    NormalizationParams normalization;
+
+    // Weights and biases in the shared flat layout
+    alignas(WEIGHT_ALIGNMENT) std::array<Scalar, PARAMETER_COUNT> parameters{};
+
+    // Random number generator for weight initialization and shuffling
+    std::mt19937 gen;
+
+    MathMode math_mode = MathMode::Exact;
+
+    // Normalized state written to the (zero padded) input layer
+    void normalize_input(const GameState& state, Scalar* out) const
+    {
+        for (int k = 0; k < INPUTS; ++k)
+        {
+            out[k] = Scalar(0);
+        }
+        out[0] = static_cast<Scalar>((state.bally - normalization.mean_bally) / normalization.std_bally);
+        out[1] = static_cast<Scalar>((state.paddley - normalization.mean_paddley) / normalization.std_paddley);
+    }
+
+    // Propagation through net ----------------------------------------------
+
+    // Layer L to L+1, tanh on hidden layers and raw logits on the output
+    template <std::size_t L>
+    void forward_layer(Scalar* activations) const
+    {
+        constexpr int rows = LAYER_SIZES[L + 1];
+        constexpr int cols = LAYER_SIZES[L];
+        const Scalar* __restrict w = parameters.data() + fixed_weight_offset<Scalar>(LAYER_SIZES, L);
+        const Scalar* __restrict b = parameters.data() + fixed_bias_offset<Scalar>(LAYER_SIZES, L);
+        const Scalar* __restrict input = activations + fixed_activation_offset(LAYER_SIZES, L);
+        Scalar* __restrict output = activations + fixed_activation_offset(LAYER_SIZES, L + 1);
+
+        // One output per lane, the sums stay in registers across the inputs
+#pragma omp simd
+        for (int j = 0; j < rows; ++j)
+        {
+            Scalar sum = b[j];
+            for (int k = 0; k < cols; ++k)
+            {
+                sum += w[k * rows + j] * input[k];
+            }
+            output[j] = sum;
+        }
+
+        if (L + 2 < NUM_LAYERS)
+        {
+            tanh_inplace(output, rows, math_mode);
+        }
+    }
+
+    template <std::size_t... L>
+    void forward_layers(Scalar* activations, std::index_sequence<L...>) const
+    {
+        (forward_layer<L>(activations), ...);
+    }
+
+    // Deltas of hidden layer L from the deltas of layer L+1. The activations
+    // are stored, so the tanh derivative is 1 - a^2.
+    template <std::size_t L>
+    void backward_layer(const Scalar* activations, Scalar* deltas) const
+    {
+        constexpr int rows = LAYER_SIZES[L + 1];
+        constexpr int cols = LAYER_SIZES[L];
+        const Scalar* __restrict w = parameters.data() + fixed_weight_offset<Scalar>(LAYER_SIZES, L);
+        const Scalar* __restrict next_delta = deltas + fixed_activation_offset(LAYER_SIZES, L + 1);
+        const Scalar* __restrict a = activations + fixed_activation_offset(LAYER_SIZES, L);
+        Scalar* __restrict delta = deltas + fixed_activation_offset(LAYER_SIZES, L);
+
+        for (int k = 0; k < cols; ++k)
+        {
+            Scalar sum = Scalar(0);
+#pragma omp simd reduction(+:sum)
+            for (int j = 0; j < rows; ++j)
+            {
+                sum += w[k * rows + j] * next_delta[j];
+            }
+            delta[k] = sum * (Scalar(1) - a[k] * a[k]);
+        }
+    }
+
+    // Walks the hidden layers from the output back to layer 1 (none for a
+    // network without hidden layers)
+    template <std::size_t... L>
+    void backward_layers([[maybe_unused]] const Scalar* activations, [[maybe_unused]] Scalar* deltas, std::index_sequence<L...>) const
+    {
+        (backward_layer<NUM_LAYERS - 2 - L>(activations, deltas), ...);
+    }
+
+    // target += scale * gradient of layer L, target is laid out like parameters
+    template <std::size_t L>
+    static void gradient_layer(const Scalar* activations, const Scalar* deltas, Scalar* target, Scalar scale)
+    {
+        constexpr int rows = LAYER_SIZES[L + 1];
+        constexpr int cols = LAYER_SIZES[L];
+        Scalar* __restrict w = target + fixed_weight_offset<Scalar>(LAYER_SIZES, L);
+        Scalar* __restrict b = target + fixed_bias_offset<Scalar>(LAYER_SIZES, L);
+        const Scalar* __restrict input = activations + fixed_activation_offset(LAYER_SIZES, L);
+        const Scalar* __restrict delta = deltas + fixed_activation_offset(LAYER_SIZES, L + 1);
+
+        for (int k = 0; k < cols; ++k)
+        {
+            const Scalar step = scale * input[k];
+#pragma omp simd
+            for (int j = 0; j < rows; ++j)
+            {
+                w[k * rows + j] += step * delta[j];
+            }
+        }
+#pragma omp simd
+        for (int j = 0; j < rows; ++j)
+        {
+            b[j] += scale * delta[j];
+        }
+    }
+
+    template <std::size_t... L>
+    static void gradient_layers(const Scalar* activations, const Scalar* deltas, Scalar* target, Scalar scale, std::index_sequence<L...>)
+    {
+        (gradient_layer<L>(activations, deltas, target, scale), ...);
+    }
+
+    // Index of the largest logit, softmax keeps their order
+    static int argmax_output(const Scalar* activations)
+    {
+        const Scalar* logits = activations + fixed_activation_offset(LAYER_SIZES, NUM_LAYERS - 1);
+        int best = 0;
+        for (int j = 1; j < OUTPUTS; ++j)
+        {
+            if (logits[j] > logits[best])
+            {
+                best = j;
+            }
+        }
+        return best;
+    }
+
+    // Loss and gradient magnitudes accumulated over an epoch
+    struct EpochStats
+    {
+        double total_loss = 0.0;
+        double max_gradient = 0.0;
+        double min_gradient = std::numeric_limits<double>::max();
+    };
+
+    // One forward pass, softmax cross entropy and the backward pass for a
+    // single sample. Leaves activations and deltas ready for gradient_layers.
+    void forward_backward(const GameState& state, int target, Activations& activations, Activations& deltas, EpochStats& stats) const
+    {
+        normalize_input(state, activations.data());
+        forward_layers(activations.data(), LayerIndices());
+
+        // Softmax cross entropy, the output delta is probabilities minus target
+        Scalar* output = activations.data() + fixed_activation_offset(LAYER_SIZES, NUM_LAYERS - 1);
+        Scalar* output_delta = deltas.data() + fixed_activation_offset(LAYER_SIZES, NUM_LAYERS - 1);
+        softmax_inplace(output, OUTPUTS, math_mode);
+
+        stats.total_loss += -std::log(std::max<double>(output[target], 1e-15));
+        for (int j = 0; j < OUTPUTS; ++j)
+        {
+            output_delta[j] = output[j] - (j == target ? Scalar(1) : Scalar(0));
+            stats.max_gradient = std::max<double>(stats.max_gradient, std::abs(output_delta[j]));
+            stats.min_gradient = std::min<double>(stats.min_gradient, std::abs(output_delta[j]));
+        }
+
+        backward_layers(activations.data(), deltas.data(), HiddenIndices());
+    }
+
+public:
+    // Constructor: random weights from a nondeterministic seed
+    BasicFixedPongNetwork() : BasicFixedPongNetwork(std::random_device()()) {}
+
+    // Same initialization as BasicPongNeuralNetwork with the same seed
+    explicit BasicFixedPongNetwork(unsigned seed) : gen(seed)
+    {
+        std::uniform_real_distribution<> dis(-1.0, 1.0);
+        for (std::size_t i = 0; i < NUM_LAYERS - 1; ++i)
+        {
+            // Xavier/Glorot initialization, drawn in row major order so the
+            // values match the dynamic network's
+            double scale = std::sqrt(2.0 / (LAYER_SIZES[i] + LAYER_SIZES[i + 1]));
+            Scalar* w = parameters.data() + fixed_weight_offset<Scalar>(LAYER_SIZES, i);
+            for (int j = 0; j < LAYER_SIZES[i + 1]; ++j)
+            {
+                for (int k = 0; k < LAYER_SIZES[i]; ++k)
+                {
+                    w[k * LAYER_SIZES[i + 1] + j] = static_cast<Scalar>(dis(gen) * scale);
+                }
+            }
+
+            Scalar* b = parameters.data() + fixed_bias_offset<Scalar>(LAYER_SIZES, i);
+            for (int j = 0; j < LAYER_SIZES[i + 1]; ++j)
+            {
+                b[j] = static_cast<Scalar>(dis(gen));
+            }
+        }
+    }
+
+    // Copy the weights of a dynamic network, false if its architecture differs
+    bool copy_from(const BasicPongNeuralNetwork<Scalar>& network)
+    {
+        const std::vector<int>& sizes = network.get_layer_sizes();
+        if (!std::equal(sizes.begin(), sizes.end(), LAYER_SIZES.begin(), LAYER_SIZES.end()))
+        {
+            std::cerr << "Network architecture does not match the fixed network" << std::endl;
+            return false;
+        }
+
+        normalization = network.get_normalization();
+        math_mode = network.get_math_mode();
+        for (std::size_t i = 0; i < NUM_LAYERS - 1; ++i)
+        {
+            transpose_weights(network.get_layer_weights(i), parameters.data() + fixed_weight_offset<Scalar>(LAYER_SIZES, i),
+                              LAYER_SIZES[i + 1], LAYER_SIZES[i]);
+            std::copy_n(network.get_layer_biases(i), LAYER_SIZES[i + 1], parameters.data() + fixed_bias_offset<Scalar>(LAYER_SIZES, i));
+        }
+        return true;
+    }
+
+    NormalizationParams get_normalization() const { return normalization; }
+
+    // Exact uses libm, Fast the vectorized approximations (see fast-math.h)
+    void set_math_mode(MathMode mode) { math_mode = mode; }
+    MathMode get_math_mode() const { return math_mode; }
+
+    std::size_t parameter_bytes() const { return PARAMETER_COUNT * sizeof(Scalar); }
+
+    // Predict optimal paddle movement based on state
+    int predict_move(const GameState& gamestate) const
+    {
+        Activations activations;
+        normalize_input(gamestate, activations.data());
+        forward_layers(activations.data(), LayerIndices());
+        return argmax_output(activations.data());
+    }
+
+    // Predict moves for count games given as structure of arrays state
+    void predict_moves(const int* bally, const int* paddley, int* moves, int count) const
+    {
+        for (int n = 0; n < count; ++n)
+        {
+            moves[n] = predict_move({bally[n], paddley[n]});
+        }
+    }
+
+    // Write a model file readable by either network type
+    bool save(const std::string& filename) const
+    {
+        // Weight blocks go back to the shared row major order
+        std::vector<Scalar> shared(parameters.begin(), parameters.end());
+        for (std::size_t i = 0; i < NUM_LAYERS - 1; ++i)
+        {
+            transpose_weights(parameters.data() + fixed_weight_offset<Scalar>(LAYER_SIZES, i), shared.data() + fixed_weight_offset<Scalar>(LAYER_SIZES, i),
+                              LAYER_SIZES[i], LAYER_SIZES[i + 1]);
+        }
+
+        std::vector<int> arch(LAYER_SIZES.begin(), LAYER_SIZES.end());
+        return write_model_file(filename, arch, normalization, shared.data(), PARAMETER_COUNT, sizeof(Scalar));
+    }
+
+    // Read a model file written by either network type, nullptr on error
+    // or if the file holds a different architecture
+    static std::unique_ptr<BasicFixedPongNetwork> load(const std::string& filename)
+    {
+        std::unique_ptr<BasicPongNeuralNetwork<Scalar>> network = BasicPongNeuralNetwork<Scalar>::load(filename);
+        std::unique_ptr<BasicFixedPongNetwork> fixed(new BasicFixedPongNetwork(0));
+        if (!network || !fixed->copy_from(*network))
+        {
+            return nullptr;
+        }
+        return fixed;
+    }
+
+    // Train method, same as BasicPongNeuralNetwork::train. Mini-batches
+    // are averaged like the dynamic network, summed per shard_size shard
+    // and the shards reduced in order, but always on the calling thread.
+    // Options asking for more threads or for detailed metrics are rejected.
+    void train(const std::vector<GameState>& training_data, const std::vector<int>& expected_moves, double learning_rate, int epochs,
+               const TrainOptions& options = TrainOptions())
+    {
+        TrainingView view;
+        if (!training_data.empty())
+        {
+            view.bally = &training_data.data()->bally;
+            view.paddley = &training_data.data()->paddley;
+        }
+        view.moves = expected_moves.data();
+        view.state_stride = sizeof(GameState) / sizeof(int);
+        view.size = std::min(training_data.size(), expected_moves.size());
+        train(view, learning_rate, epochs, options);
+    }
+
+    void train(const TrainingView& training_data, double learning_rate, int epochs, const TrainOptions& options = TrainOptions())
+    {
+        if (training_data.size == 0)
+        {
+            std::cerr << "No training data" << std::endl;
+            return;
+        }
+
+        const int batch_size = std::max(1, options.batch_size);
+        const int shard_size = std::max(1, std::min(options.shard_size, batch_size));
+        if (batch_size > 1 && options.num_threads != 1)
+        {
+            std::cerr << "The fixed network trains on one thread, num_threads must be 1" << std::endl;
+            return;
+        }
+        if (options.detailed_metrics)
+        {
+            std::cerr << "The fixed network does not collect detailed metrics" << std::endl;
+            return;
+        }
+
+        if (!options.keep_normalization)
+        {
+            normalization = compute_normalization(training_data);
+        }
+
+        // Every buffer is sized up front, the epoch loop never allocates
+        Activations activations;
+        Activations deltas;
+        std::vector<Scalar> gradients(batch_size > 1 ? PARAMETER_COUNT : 0);
+        std::vector<Scalar> shard_gradients(batch_size > 1 ? PARAMETER_COUNT : 0);
+        std::vector<int> indices(training_data.size);
+
+        // Metrics go to the caller's sink or, by default, to std::cout
+        TextTrainingSink default_sink(std::cout);
+        TrainingSink& sink = options.sink ? *options.sink : default_sink;
+        EpochMetrics metrics;
+        metrics.epochs = epochs;
+        metrics.samples = training_data.size;
+        metrics.batch_size = batch_size;
+        metrics.threads = 1;
+
+        for (int epoch = 0; epoch < epochs; ++epoch)
+        {
+            auto epoch_start = std::chrono::steady_clock::now();
+            EpochStats stats;
+
+            // Shuffle the training data
+            std::iota(indices.begin(), indices.end(), 0);
+            std::shuffle(indices.begin(), indices.end(), gen);
+
+            for (std::size_t start = 0; start < training_data.size; start += batch_size)
+            {
+                int count = static_cast<int>(std::min<std::size_t>(batch_size, training_data.size - start));
+                if (batch_size > 1)
+                {
+                    std::fill(gradients.begin(), gradients.end(), Scalar(0));
+                }
+
+                for (int n = 0; n < count; ++n)
+                {
+                    int index = indices[start + n];
+                    forward_backward({training_data.bally_at(index), training_data.paddley_at(index)}, training_data.moves[index],
+                                     activations, deltas, stats);
+
+                    // Per-sample SGD updates the weights directly
+                    if (batch_size > 1)
+                    {
+                        gradient_layers(activations.data(), deltas.data(), shard_gradients.data(), Scalar(1), LayerIndices());
+                        if ((n + 1) % shard_size == 0 || n + 1 == count)
+                        {
+                            scaled_add(Scalar(1), shard_gradients.data(), gradients.data(), PARAMETER_COUNT);
+                            std::fill(shard_gradients.begin(), shard_gradients.end(), Scalar(0));
+                        }
+                    }
+                    else
+                    {
+                        gradient_layers(activations.data(), deltas.data(), parameters.data(), static_cast<Scalar>(-learning_rate), LayerIndices());
+                    }
+                }
+
+                if (batch_size > 1)
+                {
+                    scaled_add(static_cast<Scalar>(-learning_rate / count), gradients.data(), parameters.data(), PARAMETER_COUNT);
+                }
+            }
+
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - epoch_start).count();
+
+            metrics.epoch = epoch + 1;
+            metrics.loss = stats.total_loss / training_data.size;
+            metrics.max_gradient = stats.max_gradient;
+            metrics.min_gradient = stats.min_gradient;
+            metrics.seconds = seconds;
+            metrics.samples_per_second = training_data.size / std::max(seconds, 1e-9);
+            sink.epoch(metrics);
+        }
+        sink.finish();
+    }
+};
+
+template <int... Layers>
+using FixedPongNetwork = BasicFixedPongNetwork<double, Layers...>;
+
+template <int... Layers>
+using FixedPongNetworkF = BasicFixedPongNetwork<float, Layers...>;
+
+// The architecture main.cpp trains
+using DefaultFixedPongNetwork = FixedPongNetwork<5, 10, 10, 3>;
+
+#endif
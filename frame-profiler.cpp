@@ -0,0 +1,256 @@
+#include "frame-profiler.h"
+#include "buffered-writer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+
+const char* frame_phase_name(FramePhase phase)
+{
+    static const char* const names[FrameProfiler::PHASES] = {
+        "events", "inference", "physics", "render", "text", "present", "frame"};
+    return names[static_cast<int>(phase)];
+}
+
+// Histogram ---------------------------------------------------------------
+
+LatencyHistogram::LatencyHistogram()
+{
+    reset();
+}
+
+int LatencyHistogram::bucket_index(uint64_t ns)
+{
+    if (ns < LINEAR_BUCKETS)
+    {
+        return static_cast<int>(ns);
+    }
+
+    // The top bucket takes everything past ~18 minutes
+    int msb = std::min(63 - __builtin_clzll(ns), 39);
+    int sub = static_cast<int>((std::min<uint64_t>(ns, (uint64_t(1) << 40) - 1) >> (msb - 3)) & (SUB_BUCKETS - 1));
+    return LINEAR_BUCKETS + (msb - 4) * SUB_BUCKETS + sub;
+}
+
+uint64_t LatencyHistogram::bucket_upper_bound(int index)
+{
+    if (index < LINEAR_BUCKETS)
+    {
+        return static_cast<uint64_t>(index);
+    }
+
+    int msb = (index - LINEAR_BUCKETS) / SUB_BUCKETS + 4;
+    uint64_t sub = (index - LINEAR_BUCKETS) % SUB_BUCKETS;
+    return ((SUB_BUCKETS + sub + 1) << (msb - 3)) - 1;
+}
+
+void LatencyHistogram::record(uint64_t ns)
+{
+    buckets[bucket_index(ns)].fetch_add(1, std::memory_order_relaxed);
+    total_count.fetch_add(1, std::memory_order_relaxed);
+    total_ns.fetch_add(ns, std::memory_order_relaxed);
+
+    uint64_t seen = max_ns.load(std::memory_order_relaxed);
+    while (ns > seen && !max_ns.compare_exchange_weak(seen, ns, std::memory_order_relaxed))
+    {
+    }
+}
+
+void LatencyHistogram::reset()
+{
+    for (auto& bucket : buckets)
+    {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    total_count.store(0, std::memory_order_relaxed);
+    total_ns.store(0, std::memory_order_relaxed);
+    max_ns.store(0, std::memory_order_relaxed);
+}
+
+double LatencyHistogram::mean() const
+{
+    uint64_t n = count();
+    return n ? static_cast<double>(total_ns.load(std::memory_order_relaxed)) / n : 0.0;
+}
+
+uint64_t LatencyHistogram::percentile(double fraction) const
+{
+    uint64_t n = count();
+    if (n == 0)
+    {
+        return 0;
+    }
+
+    // Buckets may move on while we scan, so never report past the max seen
+    uint64_t target = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(fraction * n)));
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKETS; ++i)
+    {
+        seen += buckets[i].load(std::memory_order_relaxed);
+        if (seen >= target)
+        {
+            return std::min(bucket_upper_bound(i), max());
+        }
+    }
+    return max();
+}
+
+// Profiler ----------------------------------------------------------------
+
+FrameProfiler::FrameProfiler(bool enable, size_t trace_frames)
+    : enabled(enable), trace(std::max<size_t>(trace_frames, 1))
+{
+}
+
+void FrameProfiler::set_enabled(bool enable)
+{
+    enabled = enable;
+    in_frame = false;
+}
+
+void FrameProfiler::begin_frame()
+{
+    if (!is_enabled())
+    {
+        return;
+    }
+
+    current = FrameRecord();
+    current.frame = frames;
+    frame_start = Clock::now();
+    in_frame = true;
+}
+
+void FrameProfiler::end_frame()
+{
+    if (!is_enabled() || !in_frame)
+    {
+        return;
+    }
+
+    record(FramePhase::Frame, std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - frame_start).count());
+    trace[trace_next] = current;
+    trace_next = (trace_next + 1) % trace.size();
+    ++frames;
+    in_frame = false;
+}
+
+void FrameProfiler::record(FramePhase phase, uint64_t ns)
+{
+    histograms[static_cast<int>(phase)].record(ns);
+    if (in_frame)
+    {
+        current.phase_ns[static_cast<int>(phase)] += ns;
+    }
+}
+
+std::vector<std::string> FrameProfiler::summary_lines() const
+{
+    std::vector<std::string> lines;
+    char line[96];
+    for (int i = 0; i < PHASES; ++i)
+    {
+        const LatencyHistogram& h = histograms[i];
+        std::snprintf(line, sizeof(line), "%-9s p50 %7.1f us  p99 %7.1f us  max %7.1f us",
+                      frame_phase_name(static_cast<FramePhase>(i)),
+                      h.percentile(0.50) / 1e3, h.percentile(0.99) / 1e3, h.max() / 1e3);
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+// Trace files -------------------------------------------------------------
+
+bool FrameProfiler::write_trace(const std::string& filename) const
+{
+    const std::string suffix = ".json";
+    bool json = filename.size() >= suffix.size() &&
+                filename.compare(filename.size() - suffix.size(), suffix.size(), suffix) == 0;
+    return json ? write_json(filename) : write_csv(filename);
+}
+
+bool FrameProfiler::write_json(const std::string& filename) const
+{
+    BufferedWriter out(filename);
+    if (!out.is_open())
+    {
+        std::cerr << "Error opening file: " << filename << std::endl;
+        return false;
+    }
+
+    out.write("{\n  \"phases\": [\n");
+    for (int i = 0; i < PHASES; ++i)
+    {
+        const LatencyHistogram& h = histograms[i];
+        out.write("    {\"name\": \"");
+        out.write(frame_phase_name(static_cast<FramePhase>(i)));
+        out.write("\", \"count\": ");
+        out.write_int(static_cast<long>(h.count()));
+        out.write(", \"mean_ns\": ");
+        out.write_double(h.mean());
+        out.write(", \"p50_ns\": ");
+        out.write_int(static_cast<long>(h.percentile(0.50)));
+        out.write(", \"p99_ns\": ");
+        out.write_int(static_cast<long>(h.percentile(0.99)));
+        out.write(", \"max_ns\": ");
+        out.write_int(static_cast<long>(h.max()));
+        out.write(i + 1 < PHASES ? "},\n" : "}\n");
+    }
+
+    // Oldest kept frame first
+    size_t kept = std::min<uint64_t>(frames, trace.size());
+    size_t first = frames > trace.size() ? trace_next : 0;
+    out.write("  ],\n  \"frames\": [\n");
+    for (size_t n = 0; n < kept; ++n)
+    {
+        const FrameRecord& row = trace[(first + n) % trace.size()];
+        out.write("    {\"frame\": ");
+        out.write_int(static_cast<long>(row.frame));
+        for (int i = 0; i < PHASES; ++i)
+        {
+            out.write(", \"");
+            out.write(frame_phase_name(static_cast<FramePhase>(i)));
+            out.write("_ns\": ");
+            out.write_int(static_cast<long>(row.phase_ns[i]));
+        }
+        out.write(n + 1 < kept ? "},\n" : "}\n");
+    }
+    out.write("  ]\n}\n");
+    out.flush();
+    return out.good();
+}
+
+bool FrameProfiler::write_csv(const std::string& filename) const
+{
+    BufferedWriter out(filename);
+    if (!out.is_open())
+    {
+        std::cerr << "Error opening file: " << filename << std::endl;
+        return false;
+    }
+
+    out.write("frame");
+    for (int i = 0; i < PHASES; ++i)
+    {
+        out.put(',');
+        out.write(frame_phase_name(static_cast<FramePhase>(i)));
+        out.write("_ns");
+    }
+    out.put('\n');
+
+    size_t kept = std::min<uint64_t>(frames, trace.size());
+    size_t first = frames > trace.size() ? trace_next : 0;
+    for (size_t n = 0; n < kept; ++n)
+    {
+        const FrameRecord& row = trace[(first + n) % trace.size()];
+        out.write_int(static_cast<long>(row.frame));
+        for (int i = 0; i < PHASES; ++i)
+        {
+            out.put(',');
+            out.write_int(static_cast<long>(row.phase_ns[i]));
+        }
+        out.put('\n');
+    }
+    out.flush();
+    return out.good();
+}
@@ -0,0 +1,166 @@
+#ifndef PONG_FRAME_PROFILER_H
+#define PONG_FRAME_PROFILER_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Parts of a game frame that are timed separately
+enum class FramePhase
+{
+    Events,     // SDL event polling
+    Inference,  // agent decision
+    Physics,    // simulation step
+    Render,     // clear and draw the playfield
+    Text,       // score and overlay text
+    Present,    // SDL_RenderPresent, including any vsync wait
+    Frame,      // one whole frame, begin_frame to end_frame
+    Count
+};
+
+// Short lowercase name used in the overlay and the trace files
+const char* frame_phase_name(FramePhase phase);
+
+// Lock free latency histogram in nanoseconds. Values below 16 ns get a
+// bucket each, larger ones are split into 8 buckets per power of two, so a
+// reported percentile is within 12.5% of the true value. Any thread may
+// record or read at any time, all counters are relaxed atomics.
+class LatencyHistogram
+{
+public:
+    static const int LINEAR_BUCKETS = 16;
+    static const int SUB_BUCKETS = 8;
+    static const int BUCKETS = LINEAR_BUCKETS + (40 - 4) * SUB_BUCKETS;
+
+private:
+    std::array<std::atomic<uint64_t>, BUCKETS> buckets;
+    std::atomic<uint64_t> total_count{0};
+    std::atomic<uint64_t> total_ns{0};
+    std::atomic<uint64_t> max_ns{0};
+
+    static int bucket_index(uint64_t ns);
+    static uint64_t bucket_upper_bound(int index);
+
+public:
+    LatencyHistogram();
+
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    void record(uint64_t ns);
+    void reset();
+
+    uint64_t count() const { return total_count.load(std::memory_order_relaxed); }
+    uint64_t max() const { return max_ns.load(std::memory_order_relaxed); }
+    double mean() const;
+
+    // Upper edge of the bucket holding the given fraction of samples, 0 when empty
+    uint64_t percentile(double fraction) const;
+};
+
+// Per-phase timing for the game loop. Every phase feeds a histogram, and
+// the last trace_frames frames are kept as rows for a trace dump.
+//
+// Disabled, a Scope costs one relaxed load and a branch and never reads
+// the clock, so the timers stay compiled into the loop. Everything but
+// record_concurrent belongs to the game thread.
+class FrameProfiler
+{
+public:
+    static const int PHASES = static_cast<int>(FramePhase::Count);
+
+    using Clock = std::chrono::steady_clock;
+
+    // Times one phase from construction to destruction
+    class Scope
+    {
+    private:
+        FrameProfiler* profiler;
+        FramePhase phase;
+        Clock::time_point start;
+
+    public:
+        Scope(FrameProfiler& owner, FramePhase timed)
+            : profiler(owner.is_enabled() ? &owner : nullptr), phase(timed)
+        {
+            if (profiler)
+            {
+                start = Clock::now();
+            }
+        }
+
+        ~Scope()
+        {
+            if (profiler)
+            {
+                profiler->record(phase, std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+            }
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+
+private:
+    // Nanoseconds spent in each phase during one frame
+    struct FrameRecord
+    {
+        uint64_t frame = 0;
+        std::array<uint64_t, PHASES> phase_ns{};
+    };
+
+    std::atomic<bool> enabled;
+    std::array<LatencyHistogram, PHASES> histograms;
+
+    // Ring of the most recent frames, written only by the game thread
+    std::vector<FrameRecord> trace;
+    size_t trace_next = 0;
+    uint64_t frames = 0;
+    FrameRecord current;
+    Clock::time_point frame_start;
+    bool in_frame = false;
+
+    bool write_json(const std::string& filename) const;
+    bool write_csv(const std::string& filename) const;
+
+public:
+    explicit FrameProfiler(bool enable = false, size_t trace_frames = 3600);
+
+    FrameProfiler(const FrameProfiler&) = delete;
+    FrameProfiler& operator=(const FrameProfiler&) = delete;
+
+    bool is_enabled() const { return enabled.load(std::memory_order_relaxed); }
+    void set_enabled(bool enable);
+
+    // Mark frame boundaries, end_frame records the Frame phase and the trace row
+    void begin_frame();
+    void end_frame();
+
+    // Add a measurement taken on the game thread (what a Scope does)
+    void record(FramePhase phase, uint64_t ns);
+
+    // Add a measurement taken on another thread, it only feeds the histogram
+    void record_concurrent(FramePhase phase, uint64_t ns)
+    {
+        if (is_enabled())
+        {
+            histograms[static_cast<int>(phase)].record(ns);
+        }
+    }
+
+    const LatencyHistogram& histogram(FramePhase phase) const { return histograms[static_cast<int>(phase)]; }
+    uint64_t frame_count() const { return frames; }
+
+    // One line per phase with its p50, p99 and max, for the debug overlay
+    std::vector<std::string> summary_lines() const;
+
+    // Per-phase percentiles plus the frame trace. A filename ending in
+    // .json gets a JSON document, anything else a CSV with one row per
+    // frame. Returns false if the file cannot be written.
+    bool write_trace(const std::string& filename) const;
+};
+
+#endif
@@ -0,0 +1,188 @@
+#include "inference-plan.h"
+#include <iomanip>
+
+// Game inputs read by the first layer (bally, paddley)
+const int PLAN_INPUTS = 2;
+
+// Compile -----------------------------------------------------------------
+
+template <typename Scalar>
+bool BasicInferencePlan<Scalar>::compile(const BasicPongNeuralNetwork<Scalar>& network)
+{
+    const std::vector<int>& sizes = network.get_layer_sizes();
+    layers.clear();
+    parameters.clear();
+    if (sizes.size() < 2 || sizes[0] < PLAN_INPUTS)
+    {
+        std::cerr << "Network needs at least " << PLAN_INPUTS << " inputs to compile a plan" << std::endl;
+        return false;
+    }
+
+    // Lay out every block cache line aligned, like the network itself
+    size_t offset = 0;
+    for (size_t i = 0; i < sizes.size() - 1; ++i)
+    {
+        Layer layer;
+        layer.rows = sizes[i + 1];
+        layer.cols = i == 0 ? PLAN_INPUTS : sizes[i];
+        layer.weight_offset = offset;
+        offset += aligned_size<Scalar>(static_cast<size_t>(layer.rows) * layer.cols);
+        layer.bias_offset = offset;
+        offset += aligned_size<Scalar>(layer.rows);
+        layers.push_back(layer);
+    }
+    parameters.assign(offset, Scalar(0));
+
+    const NormalizationParams norm = network.get_normalization();
+    const double mean[PLAN_INPUTS] = {norm.mean_bally, norm.mean_paddley};
+    const double std_dev[PLAN_INPUTS] = {norm.std_bally, norm.std_paddley};
+
+    for (size_t i = 0; i < layers.size(); ++i)
+    {
+        const Layer& layer = layers[i];
+        const Scalar* w = network.get_layer_weights(i);
+        const Scalar* b = network.get_layer_biases(i);
+        Scalar* plan_w = parameters.data() + layer.weight_offset;
+        Scalar* plan_b = parameters.data() + layer.bias_offset;
+
+        if (i > 0)
+        {
+            std::copy_n(w, static_cast<size_t>(layer.rows) * layer.cols, plan_w);
+            std::copy_n(b, layer.rows, plan_b);
+            continue;
+        }
+
+        // Fold normalization into the live columns of the first layer
+        for (int j = 0; j < layer.rows; ++j)
+        {
+            double bias = b[j];
+            for (int k = 0; k < PLAN_INPUTS; ++k)
+            {
+                double weight = w[static_cast<size_t>(j) * sizes[0] + k];
+                plan_w[static_cast<size_t>(j) * PLAN_INPUTS + k] = static_cast<Scalar>(weight / std_dev[k]);
+                bias -= weight * mean[k] / std_dev[k];
+            }
+            plan_b[j] = static_cast<Scalar>(bias);
+        }
+    }
+
+    widest = *std::max_element(sizes.begin() + 1, sizes.end());
+    math_mode = network.get_math_mode();
+    return true;
+}
+
+
+
+// Decide -------------------------------------------------------------------
+
+template <typename Scalar>
+void BasicInferencePlan<Scalar>::prepare_workspace(Workspace& workspace) const
+{
+    size_t needed = std::max(widest, PLAN_INPUTS);
+    if (workspace.current.size() < needed)
+    {
+        workspace.current.resize(needed);
+        workspace.next.resize(needed);
+    }
+}
+
+template <typename Scalar>
+int BasicInferencePlan<Scalar>::predict_move(const GameState& gamestate, Workspace& workspace) const
+{
+    prepare_workspace(workspace);
+    Scalar* current = workspace.current.data();
+    Scalar* next = workspace.next.data();
+    current[0] = static_cast<Scalar>(gamestate.bally);
+    current[1] = static_cast<Scalar>(gamestate.paddley);
+
+    for (size_t i = 0; i < layers.size(); ++i)
+    {
+        const Layer& layer = layers[i];
+        dense_forward(parameters.data() + layer.weight_offset, parameters.data() + layer.bias_offset, current, next, layer.rows, layer.cols);
+
+        if (i + 1 != layers.size())
+        {
+            tanh_inplace(next, layer.rows, math_mode);
+        }
+        std::swap(current, next);
+    }
+
+    return std::max_element(current, current + layers.back().rows) - current;
+}
+
+template <typename Scalar>
+int BasicInferencePlan<Scalar>::predict_move(const GameState& gamestate) const
+{
+    thread_local Workspace workspace;
+    return predict_move(gamestate, workspace);
+}
+
+
+
+// Code generation ------------------------------------------------------------
+
+template <typename Scalar>
+void BasicInferencePlan<Scalar>::emit_cpp(std::ostream& out, const std::string& function_name) const
+{
+    const char* type = sizeof(Scalar) == sizeof(float) ? "float" : "double";
+    const char* suffix = sizeof(Scalar) == sizeof(float) ? "f" : "";
+
+    out << "// Generated by InferencePlan::emit_cpp, do not edit.\n"
+        << "// Decision only pong policy with normalization folded into layer 0.\n\n"
+        << "#include <cmath>\n\n";
+
+    // Hex float literals keep every weight bit exact
+    std::ios_base::fmtflags flags = out.flags();
+    out << std::hexfloat;
+    for (size_t i = 0; i < layers.size(); ++i)
+    {
+        const Layer& layer = layers[i];
+        out << "static const " << type << " " << function_name << "_w" << i << "[" << layer.rows * layer.cols << "] = {";
+        for (int k = 0; k < layer.rows * layer.cols; ++k)
+        {
+            out << (k % 4 ? " " : "\n    ") << parameters[layer.weight_offset + k] << suffix << ",";
+        }
+        out << "\n};\n";
+
+        out << "static const " << type << " " << function_name << "_b" << i << "[" << layer.rows << "] = {";
+        for (int j = 0; j < layer.rows; ++j)
+        {
+            out << (j % 4 ? " " : "\n    ") << parameters[layer.bias_offset + j] << suffix << ",";
+        }
+        out << "\n};\n\n";
+    }
+    out.flags(flags);
+
+    // Returns 0 (down), 1 (up) or 2 (none), like PongNeuralNetwork::predict_move
+    out << "int " << function_name << "(int bally, int paddley)\n{\n"
+        << "    " << type << " a0[" << PLAN_INPUTS << "] = {static_cast<" << type << ">(bally), static_cast<" << type << ">(paddley)};\n";
+    for (size_t i = 0; i < layers.size(); ++i)
+    {
+        const Layer& layer = layers[i];
+        bool hidden = i + 1 != layers.size();
+        out << "    " << type << " a" << i + 1 << "[" << layer.rows << "];\n"
+            << "    for (int j = 0; j < " << layer.rows << "; ++j)\n    {\n"
+            << "        " << type << " sum = 0;\n"
+            << "        for (int k = 0; k < " << layer.cols << "; ++k)\n        {\n"
+            << "            sum += " << function_name << "_w" << i << "[j * " << layer.cols << " + k] * a" << i << "[k];\n"
+            << "        }\n"
+            << "        a" << i + 1 << "[j] = " << (hidden ? "std::tanh(" : "(") << "sum + " << function_name << "_b" << i << "[j]);\n"
+            << "    }\n";
+    }
+
+    const size_t last = layers.size();
+    out << "\n    int best = 0;\n"
+        << "    for (int j = 1; j < " << layers.back().rows << "; ++j)\n    {\n"
+        << "        if (a" << last << "[j] > a" << last << "[best])\n        {\n"
+        << "            best = j;\n"
+        << "        }\n"
+        << "    }\n"
+        << "    return best;\n}\n";
+}
+
+
+
+// Instantiations -----------------------------------------------------------
+
+template class BasicInferencePlan<double>;
+template class BasicInferencePlan<float>;
@@ -0,0 +1,71 @@
+#ifndef PONG_INFERENCE_PLAN_H
+#define PONG_INFERENCE_PLAN_H
+
+#include <ostream>
+#include <string>
+#include <vector>
+#include "config.h"
+#include "dense-kernels.h"
+#include "network.h"
+
+// Decision only form of a trained network, compiled once after training.
+//
+// The input normalization is folded into the first layer,
+//   W0' = W0 / std,  b0' = b0 - W0 * mean / std,
+// so the plan reads bally and paddley as they come from the game. Input
+// columns the game never fills (the zero padding up to layer_sizes[0]) are
+// dropped, and the output softmax is replaced by an argmax over the raw
+// logits, which picks the same move. Everything lives in one read-only
+// aligned block.
+template <typename Scalar>
+class BasicInferencePlan
+{
+private:
+    struct Layer
+    {
+        int rows = 0;
+        int cols = 0;
+        size_t weight_offset = 0;
+        size_t bias_offset = 0;
+    };
+
+    std::vector<Layer> layers;
+    AlignedVector<Scalar> parameters;
+    int widest = 0;
+
+    // Taken from the compiled network, so the plan decides exactly like it
+    MathMode math_mode = MathMode::Exact;
+
+public:
+    using Workspace = BasicInferenceWorkspace<Scalar>;
+
+    // Fold a trained network into this plan, returns false if it cannot
+    // take the two game inputs
+    bool compile(const BasicPongNeuralNetwork<Scalar>& network);
+
+    bool empty() const { return layers.empty(); }
+    size_t parameter_bytes() const { return parameters.size() * sizeof(Scalar); }
+
+    // Size a workspace so later predictions never allocate
+    void prepare_workspace(Workspace& workspace) const;
+
+    // Predict optimal paddle movement based on state
+    int predict_move(const GameState& gamestate, Workspace& workspace) const;
+
+    // Same as above using a per-thread workspace
+    int predict_move(const GameState& gamestate) const;
+
+    // Write the plan as a standalone C++ function
+    //   int function_name(int bally, int paddley)
+    // with the weights as bit exact constant arrays. The emitted code always
+    // uses std::tanh, whatever the math mode.
+    void emit_cpp(std::ostream& out, const std::string& function_name) const;
+};
+
+using InferencePlan = BasicInferencePlan<double>;
+using InferencePlanF = BasicInferencePlan<float>;
+
+extern template class BasicInferencePlan<double>;
+extern template class BasicInferencePlan<float>;
+
+#endif
@@ -0,0 +1,150 @@
+#include "intercept.h"
+#include <algorithm>
+
+// Lattice fold ------------------------------------------------------------
+
+// The walls as PongSimulation tests them, a ball turns on the first step
+// at or past one
+const int WALL_TOP = BALL_SIZE;
+const int WALL_BOTTOM = SCREEN_HEIGHT - BALL_SIZE;
+const int WALL_RIGHT = SCREEN_WIDTH - BALL_SIZE;
+
+// First x that has passed the paddle's right edge
+const int PADDLE_FACE = PADDLE_X + PADDLE_WIDTH;
+
+// a / m rounded toward zero for a >= 0, m > 0. Integer division has no
+// SIMD instruction, the quotient of two small integers in double is exact
+// enough that truncating it never lands on the wrong side.
+static inline int quotient(int a, int m)
+{
+    return static_cast<int>(static_cast<double>(a) / static_cast<double>(m));
+}
+
+// Ceiling of a / m for a >= 0, m > 0
+static inline int ceil_quotient(int a, int m)
+{
+    return quotient(a + m - 1, m);
+}
+
+// One ball. Conditions are 0/-1 masks as in PongBatchSimulation::step, so
+// the body is straight line code find_intercepts can vectorize.
+static inline void intercept_lane(int x, int y, int dx, int dy, int& hit_y, int& ticks)
+{
+    // Steps until the paddle column, through the right wall when moving away
+    int speed_x = dx < 0 ? -dx : dx;
+    // A ball that is, or after one step still is, at or past the right wall
+    // while headed right flips back onto the same columns every step and
+    // never arrives
+    int trapped = -(((dx > 0) & (x >= WALL_RIGHT)) | ((dx < 0) & (x + dx >= WALL_RIGHT)));
+    int moving = -(speed_x > 0) & ~trapped;
+    int safe_x = speed_x > 0 ? speed_x : 1;
+    int to_right = WALL_RIGHT - x;
+    to_right = to_right > 0 ? to_right : 0;
+    int outward = ceil_quotient(to_right, safe_x) & -(dx > 0);
+    int to_face = x + safe_x * outward - PADDLE_FACE;
+    int reaching = -(to_face >= 0);
+    to_face = to_face > 0 ? to_face : 0;
+    int inward = (quotient(to_face, safe_x) + 1) & reaching;
+    int steps = outward + inward;
+
+    // Turning points on the ball's lattice
+    int speed_y = dy < 0 ? -dy : dy;
+    int safe_y = speed_y > 0 ? speed_y : 1;
+    int above = y - WALL_TOP;
+    above = above > 0 ? above : 0;
+    int below = WALL_BOTTOM - y;
+    below = below > 0 ? below : 0;
+    int low = y - safe_y * ceil_quotient(above, safe_y);
+    int high = y + safe_y * ceil_quotient(below, safe_y);
+    int span = high - low;
+    span = span > 0 ? span : 1;
+
+    // Fold the straight line path into the triangle wave, which is even
+    // around low, so only the distance from it matters
+    int travelled = y + steps * dy - low;
+    travelled = travelled < 0 ? -travelled : travelled;
+    int phase = travelled - 2 * span * quotient(travelled, 2 * span);
+    int descending = -(phase > span);
+    int folded = low + (phase & ~descending) + ((2 * span - phase) & descending);
+
+    // A paddle hit can push the ball past a wall, where the wall test then
+    // passes on every step and the ball jitters between two heights
+    int past_top = -(((dy < 0) & (y <= WALL_TOP)) | ((dy > 0) & (y + dy <= WALL_TOP)));
+    int past_bottom = -(((dy > 0) & (y >= WALL_BOTTOM)) | ((dy < 0) & (y + dy >= WALL_BOTTOM)));
+    int stuck = past_top | past_bottom;
+    int jitter = y + (dy & -(steps & 1));
+    int landed = (folded & ~stuck) | (jitter & stuck);
+
+    hit_y = (landed & moving) | (y & ~moving);
+    ticks = (steps & moving) | ~moving;
+}
+
+void find_intercepts(const int* x, const int* y, const int* dx, const int* dy, int* hit_y, int* ticks, int count)
+{
+    const int* __restrict bx = x;
+    const int* __restrict by = y;
+    const int* __restrict sx = dx;
+    const int* __restrict sy = dy;
+    int* __restrict out_y = hit_y;
+    int* __restrict out_ticks = ticks;
+
+#pragma omp simd
+    for (int i = 0; i < count; ++i)
+    {
+        int lane_y;
+        int lane_ticks;
+        intercept_lane(bx[i], by[i], sx[i], sy[i], lane_y, lane_ticks);
+        out_y[i] = lane_y;
+        out_ticks[i] = lane_ticks;
+    }
+}
+
+// One ball through the same loop, so the fold has a single copy to inline
+Intercept find_intercept(int x, int y, int dx, int dy)
+{
+    Intercept intercept;
+    find_intercepts(&x, &y, &dx, &dy, &intercept.y, &intercept.ticks, 1);
+    return intercept;
+}
+
+// Policies ----------------------------------------------------------------
+
+int intercept_move(int hit_y, int paddley)
+{
+    int offset = (hit_y + BALL_SIZE / 2) - (paddley + PADDLE_HEIGHT / 2);
+    int deadband = PADDLE_SPEED / 2;
+    int down = -(offset > deadband);
+    int up = -(offset < -deadband);
+    return (MOVE_DOWN & down) | (MOVE_UP & up) | (MOVE_NONE & ~(down | up));
+}
+
+// Balls per pass, the intercepts of one chunk stay in L1
+static const int MOVE_CHUNK = 256;
+
+void intercept_moves(const int* x, const int* y, const int* dx, const int* dy, const int* paddley, int* moves, int count)
+{
+    int hit_y[MOVE_CHUNK];
+    int ticks[MOVE_CHUNK];
+
+    for (int start = 0; start < count; start += MOVE_CHUNK)
+    {
+        int n = std::min(MOVE_CHUNK, count - start);
+        find_intercepts(x + start, y + start, dx + start, dy + start, hit_y, ticks, n);
+
+        const int* __restrict py = paddley + start;
+        int* __restrict out = moves + start;
+
+#pragma omp simd
+        for (int i = 0; i < n; ++i)
+        {
+            out[i] = intercept_move(hit_y[i], py[i]);
+        }
+    }
+}
+
+int intercept_policy(const PongSimulation& sim)
+{
+    const Rect& ball = sim.get_ball();
+    Intercept intercept = find_intercept(ball.x, ball.y, sim.get_ball_speedx(), sim.get_ball_speedy());
+    return intercept_move(intercept.y, sim.get_paddle().y);
+}
@@ -0,0 +1,45 @@
+#ifndef PONG_INTERCEPT_H
+#define PONG_INTERCEPT_H
+
+#include "config.h"
+#include "pong-sim.h"
+
+// Where the ball next reaches the paddle's column: its y on the first step
+// that puts it left of the paddle's right edge while moving left, and how
+// many steps away that is. A ball just returned by the paddle is headed
+// right, so its next crossing is after the right wall. ticks is -1 (and y
+// the current one) for a ball that never gets there: one with no
+// horizontal speed, or one the right wall holds, which flips back onto
+// the same columns every step from past it.
+struct Intercept
+{
+    int y;
+    int ticks;
+};
+
+// Closed form, constant time. Under the PongSimulation rules a ball only
+// ever visits y values on the lattice y0 + k * |dy|, and it turns on the
+// first lattice point at or past either wall, so its height is a triangle
+// wave between those two turning points. The horizontal distance to the
+// paddle, through the right wall bounce when moving away, gives the step
+// count, and folding y0 + ticks * dy into the wave gives the height then.
+// Agrees exactly with stepping the simulation from any state, including a
+// ball a paddle hit pushed past a wall, which then jitters between y and
+// y + dy.
+Intercept find_intercept(int x, int y, int dx, int dy);
+
+// find_intercept for count balls given as structure of arrays. The body is
+// branch free and vectorizes.
+void find_intercepts(const int* x, const int* y, const int* dx, const int* dy, int* hit_y, int* ticks, int count);
+
+// Steer the paddle centre toward where the ball centre will cross,
+// standing still within half a paddle step of it
+int intercept_move(int hit_y, int paddley);
+
+// Optimal moves for count trajectory states, for labelling data in bulk
+void intercept_moves(const int* x, const int* y, const int* dx, const int* dy, const int* paddley, int* moves, int count);
+
+// Baseline policy that plays from the full ball state instead of a network
+int intercept_policy(const PongSimulation& sim);
+
+#endif
@@ -2,45 +2,333 @@
 #include "config.h"
 #include "pong.h"
 #include "train-data.h"
+#include "pong-sim.h"
+#include "pong-batch.h"
+#include "dataset.h"
+#include "inference-plan.h"
+#include "async-agent.h"
+#include "training-metrics.h"
+#include "sweep.h"
+#include "evolution.h"
+#include "online-learner.h"
+#include "intercept.h"
+#include <cstring>
 
 using namespace std;
 
-int main()
+int main(int argc, char* argv[])
 {
-    // Setup training data generation objects
-    PongStateGenerator generator;
-    vector<TrainData> states;
-    std::string statesfilename = "statesdata.csv";
+    // --headless <ticks> scores the agent without opening a window,
+    // --games <n> runs that many games side by side,
+    // --save <file> writes the trained model, --load <file> skips training,
+    // --emit-plan <file> writes the decision path as generated C++ source,
+    // --policy-table answers moves from a precomputed table of every state,
+    // --fast-math trains and plays with the vectorized tanh and exp,
+    // --profile <file> times every frame and writes a .json or .csv trace on exit,
+    // --async-agent runs inference on its own thread,
+    // --metrics <file> writes detailed per-epoch training metrics as JSON lines,
+    // --sweep grid|random:<n> trains many configurations at once and ranks them,
+    // --sweep-space <file> sets the values the sweep tries (see sweep.h),
+    // --evolve <generations> optimizes the weights for in-game score, starting
+    // from the loaded model or, without --load, from random weights,
+    // --online keeps training on the states of the game while it is played,
+    // --adaptive <n> trains on about n states sampled near the decision boundary,
+    // --baseline scores the closed form intercept policy instead of the network
+    long headless_ticks = 0;
+    int headless_games = 1;
+    std::string save_filename;
+    std::string load_filename;
+    std::string plan_filename;
+    bool use_policy_table = false;
+    bool fast_math = false;
+    std::string profile_filename;
+    bool async_agent = false;
+    std::string metrics_filename;
+    std::string sweep_mode;
+    std::string sweep_space_filename;
+    int evolve_generations = 0;
+    bool online = false;
+    long adaptive_budget = 0;
+    bool baseline = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--headless") == 0 && i + 1 < argc)
+        {
+            headless_ticks = std::atol(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--games") == 0 && i + 1 < argc)
+        {
+            headless_games = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--save") == 0 && i + 1 < argc)
+        {
+            save_filename = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--load") == 0 && i + 1 < argc)
+        {
+            load_filename = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--emit-plan") == 0 && i + 1 < argc)
+        {
+            plan_filename = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--policy-table") == 0)
+        {
+            use_policy_table = true;
+        }
+        else if (std::strcmp(argv[i], "--fast-math") == 0)
+        {
+            fast_math = true;
+        }
+        else if (std::strcmp(argv[i], "--profile") == 0 && i + 1 < argc)
+        {
+            profile_filename = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--async-agent") == 0)
+        {
+            async_agent = true;
+        }
+        else if (std::strcmp(argv[i], "--metrics") == 0 && i + 1 < argc)
+        {
+            metrics_filename = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--sweep") == 0 && i + 1 < argc)
+        {
+            sweep_mode = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--sweep-space") == 0 && i + 1 < argc)
+        {
+            sweep_space_filename = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--evolve") == 0 && i + 1 < argc)
+        {
+            evolve_generations = std::max(0, std::atoi(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--online") == 0)
+        {
+            online = true;
+        }
+        else if (std::strcmp(argv[i], "--adaptive") == 0 && i + 1 < argc)
+        {
+            adaptive_budget = std::max(0L, std::atol(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--baseline") == 0)
+        {
+            baseline = true;
+        }
+    }
+
+    if (!sweep_mode.empty())
+    {
+        SweepSpace space;
+        if (!sweep_space_filename.empty() && !space.load(sweep_space_filename))
+        {
+            return 1;
+        }
+
+        std::vector<SweepConfig> configs;
+        if (sweep_mode == "grid")
+        {
+            configs = space.grid();
+        }
+        else if (sweep_mode.compare(0, 7, "random:") == 0 && std::atoi(sweep_mode.c_str() + 7) > 0)
+        {
+            configs = space.sample(std::atoi(sweep_mode.c_str() + 7), std::random_device()());
+        }
+        else
+        {
+            std::cerr << "Unknown sweep mode: " << sweep_mode << " (expected grid or random:<n>)" << std::endl;
+            return 1;
+        }
+
+        PongStateGenerator generator;
+        TrainingDataset states;
+        std::string statesfilename = "statesdata.csv";
+        generator.setAdaptiveBudget(adaptive_budget);
+        generator.ensureDataCSV(statesfilename);
+        if (!states.load(statesfilename))
+        {
+            return 1;
+        }
+        print_dataset_stats(compute_dataset_stats(states.view()), cout);
+
+        SweepOptions options;
+        if (headless_ticks > 0)
+        {
+            options.play_ticks = headless_ticks;
+        }
+
+        cout << "Sweeping " << configs.size() << " configurations...\n";
+        std::vector<SweepResult> results = run_sweep(configs, states.view(), holdout_states(states.view()), options);
+        rank_sweep_results(results);
+        print_sweep_results(results, cout);
+        return 0;
+    }
+
+    std::unique_ptr<PongNeuralNetwork> network;
+    if (!load_filename.empty())
+    {
+        // Reuse a trained model, weights are read straight from the mapped file
+        network = PongNeuralNetwork::load(load_filename);
+        if (!network)
+        {
+            return 1;
+        }
+        cout << "Loaded model from " << load_filename << "\n";
+        network->set_math_mode(fast_math ? MathMode::Fast : MathMode::Exact);
+    }
+    else
+    {
+        // Setup training data generation objects
+        PongStateGenerator generator;
+        TrainingDataset states;
+        std::string statesfilename = "statesdata.csv";
+
+        cout << "Generating training data...\n";
+
+        generator.setAdaptiveBudget(adaptive_budget);
+        generator.ensureDataCSV(statesfilename);
+        if (!states.load(statesfilename))
+        {
+            return 1;
+        }
+        print_dataset_stats(compute_dataset_stats(states.view()), cout);
 
-    cout << "Generating training data...\n";
+        // Setup network with 2 inputs, 20 hidden nuerons in 2 layers, 3 outputs (up down none)
+        network.reset(new PongNeuralNetwork({5, 10, 10, 3}));
+        network->set_math_mode(fast_math ? MathMode::Fast : MathMode::Exact);
 
-    generator.generateDataCSV(statesfilename);
-    states = generator.readCSV(statesfilename);
+        if (evolve_generations > 0)
+        {
+            // Evolution scores play rather than the optimal moves, it only
+            // needs the inputs scaled
+            network->set_normalization(compute_normalization(states.view()));
+        }
+        else
+        {
+            // Begin fitting the model to the training data, reading the columns in place
+            cout << "starting training...\n";
 
-    // Setup network with 2 inputs, 20 hidden nuerons in 2 layers, 3 outputs (up down none)
-    PongNeuralNetwork network({5, 10, 10, 3});
+            // Learning rate 0.0001, 10 epochs
+            TrainOptions options;
+            std::unique_ptr<JsonLinesTrainingSink> metrics;
+            if (!metrics_filename.empty())
+            {
+                metrics.reset(new JsonLinesTrainingSink(metrics_filename));
+                if (!metrics->is_open())
+                {
+                    return 1;
+                }
+                options.sink = metrics.get();
+                options.detailed_metrics = true;
+            }
+            network->train(states.view(), 0.0001, 500, options);
+            cout << "Training complete.\n";
+        }
+    }
 
-    // Separate game states and their corresponding optimal moves
-    std::vector<GameState> inputs;
-    std::vector<int> expected_moves;
+    if (evolve_generations > 0)
+    {
+        cout << "Evolving for " << evolve_generations << " generations...\n";
+        EvolutionOptions options;
+        options.seed = std::random_device()();
+        NeuroEvolution evolution(*network, options);
+        evolution.run(evolve_generations);
+        network.reset(new PongNeuralNetwork(evolution.best()));
+        cout << "Evolution complete, best fitness " << evolution.get_best_fitness() << "\n";
+    }
 
-    for (const auto& state : states) {
-        // Assuming the GameState struct has an 'optimalmove' field
-        inputs.push_back({state.bally, state.paddley});
-        expected_moves.push_back(state.optimalmove);
+    // A loaded model is only written back out when evolution changed it
+    if (!save_filename.empty() && (load_filename.empty() || evolve_generations > 0) && !network->save(save_filename))
+    {
+        return 1;
     }
 
+    if (!plan_filename.empty())
+    {
+        InferencePlan plan;
+        std::ofstream planfile(plan_filename);
+        if (!planfile.is_open())
+        {
+            std::cerr << "Error opening file: " << plan_filename << std::endl;
+            return 1;
+        }
+        if (!plan.compile(*network))
+        {
+            return 1;
+        }
+        plan.emit_cpp(planfile, "pong_policy");
+        cout << "Wrote inference plan to " << plan_filename << "\n";
+    }
 
-    // Begin fitting the model to the training data
-    cout << "starting training...\n";
+    if (use_policy_table)
+    {
+        network->enable_policy_table(true);
+        cout << "Built policy table\n";
+    }
 
-    // Learning rate 0.0001, 10 epochs
-    network.train(inputs, expected_moves, 0.0001, 500);
+    if (headless_ticks > 0)
+    {
+        cout << (baseline ? "Running headless evaluation of the intercept baseline...\n" : "Running headless evaluation...\n");
+        SimReport report;
+        if (headless_games > 1)
+        {
+            PongBatchSimulation sim(headless_games, 1);
+            BatchInferenceWorkspace workspace;
+            report = run_headless_batch(sim, [&](const int* bally, const int* paddley, int* moves, int count) {
+                if (baseline)
+                {
+                    intercept_moves(sim.ballx(), bally, sim.speedx(), sim.speedy(), paddley, moves, count);
+                }
+                else
+                {
+                    network->predict_moves(bally, paddley, moves, count, workspace);
+                }
+            }, headless_ticks);
+        }
+        else
+        {
+            PongSimulation sim;
+            InferenceWorkspace workspace;
+            report = run_headless(sim, [&](const GameState& state) {
+                return baseline ? intercept_policy(sim) : network->predict_move(state, workspace);
+            }, headless_ticks);
+        }
+        print_sim_report(report, cout);
+        return 0;
+    }
 
     // Play the game with the network
-    cout << "Training complete. Starting game with trained agent...\n";
-    PongGame pong(&network);
+    cout << "Starting game with trained agent...\n";
+    PongGame pong(network.get());
+    pong.get_profiler().set_enabled(!profile_filename.empty());
+    pong.set_online_learning(online);
+    pong.set_async_agent(async_agent);
     pong.run(true);
 
+    if (const AsyncAgent* agent = pong.get_async_agent())
+    {
+        AsyncAgent::Stats stats = agent->get_stats();
+        cout << "Agent decisions: " << stats.decisions << "/" << stats.published
+             << " - Staleness mean: " << stats.mean_staleness() << " ticks, max: " << stats.max_staleness
+             << " - Dropped: " << stats.dropped << "\n";
+    }
+
+    if (const OnlineLearner* learner = pong.get_online_learner())
+    {
+        OnlineLearner::Stats stats = learner->get_stats();
+        cout << "Online updates: " << stats.updates << " from " << stats.recorded << " states"
+             << " - Dropped: " << stats.dropped << "\n";
+    }
+
+    if (!profile_filename.empty())
+    {
+        if (!pong.get_profiler().write_trace(profile_filename))
+        {
+            return 1;
+        }
+        cout << "Wrote frame trace to " << profile_filename << "\n";
+    }
+
     return 0;
-}
\ No newline at end of file
+}
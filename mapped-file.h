@@ -0,0 +1,30 @@
+#ifndef PONG_MAPPED_FILE_H
+#define PONG_MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+// Read only, shared memory mapping of a whole file. Pages are shared with
+// every other process mapping the same file.
+class MappedFile
+{
+private:
+    const char* bytes = nullptr;
+    std::size_t length = 0;
+
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Map filename, printing the reason and returning false on failure
+    bool open(const std::string& filename);
+    void close();
+
+    const char* data() const { return bytes; }
+    std::size_t size() const { return length; }
+};
+
+#endif
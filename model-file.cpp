@@ -0,0 +1,151 @@
+#include "network.h"
+#include "model-file.h"
+#include "mapped-file.h"
+#include <cstring>
+
+// Round a byte offset up to the weight alignment
+static uint64_t align_offset(uint64_t offset)
+{
+    return (offset + WEIGHT_ALIGNMENT - 1) / WEIGHT_ALIGNMENT * WEIGHT_ALIGNMENT;
+}
+
+// Save model --------------------------------------------------------------
+
+bool write_model_file(const std::string& filename, const std::vector<int>& arch, const NormalizationParams& normalization,
+                      const void* parameters, uint64_t count, uint32_t scalar_size)
+{
+    ModelFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, MODEL_FILE_MAGIC, sizeof(header.magic));
+    header.version = MODEL_FILE_VERSION;
+    header.scalar_size = scalar_size;
+    header.num_layers = static_cast<uint32_t>(arch.size());
+    header.mean_bally = normalization.mean_bally;
+    header.std_bally = normalization.std_bally;
+    header.mean_paddley = normalization.mean_paddley;
+    header.std_paddley = normalization.std_paddley;
+    header.parameters_offset = align_offset(sizeof(header) + arch.size() * sizeof(int32_t));
+    header.parameters_count = count;
+
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        std::cerr << "Error opening file: " << filename << std::endl;
+        return false;
+    }
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (int size : arch)
+    {
+        int32_t value = size;
+        file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    // Pad so the parameter block starts aligned in the mapped file
+    std::vector<char> padding(header.parameters_offset - sizeof(header) - arch.size() * sizeof(int32_t), 0);
+    file.write(padding.data(), padding.size());
+    file.write(reinterpret_cast<const char*>(parameters), count * scalar_size);
+
+    if (!file)
+    {
+        std::cerr << "Error writing model file: " << filename << std::endl;
+        return false;
+    }
+
+    std::cout << "Saved model with " << count << " parameters to " << filename << std::endl;
+    return true;
+}
+
+template <typename Scalar>
+bool BasicPongNeuralNetwork<Scalar>::save(const std::string& filename) const
+{
+    return write_model_file(filename, layer_sizes, get_normalization(), parameter_data(), parameter_count, sizeof(Scalar));
+}
+
+
+
+// Load model --------------------------------------------------------------
+
+template <typename Scalar>
+std::unique_ptr<BasicPongNeuralNetwork<Scalar>> BasicPongNeuralNetwork<Scalar>::load(const std::string& filename)
+{
+    auto file = std::make_shared<MappedFile>();
+    if (!file->open(filename))
+    {
+        return nullptr;
+    }
+
+    // Validate the header before trusting any offsets
+    ModelFileHeader header;
+    if (file->size() < sizeof(header))
+    {
+        std::cerr << "Model file too small: " << filename << std::endl;
+        return nullptr;
+    }
+    std::memcpy(&header, file->data(), sizeof(header));
+
+    if (std::memcmp(header.magic, MODEL_FILE_MAGIC, sizeof(header.magic)) != 0)
+    {
+        std::cerr << "Not a pong model file: " << filename << std::endl;
+        return nullptr;
+    }
+    if (header.version != MODEL_FILE_VERSION)
+    {
+        std::cerr << "Unsupported model file version " << header.version << ": " << filename << std::endl;
+        return nullptr;
+    }
+    if (header.scalar_size != sizeof(Scalar))
+    {
+        std::cerr << "Model file stores " << header.scalar_size << " byte weights, expected " << sizeof(Scalar) << ": " << filename << std::endl;
+        return nullptr;
+    }
+    if (header.num_layers < 2 || sizeof(header) + header.num_layers * sizeof(int32_t) > file->size())
+    {
+        std::cerr << "Corrupt model architecture: " << filename << std::endl;
+        return nullptr;
+    }
+
+    std::vector<int> arch(header.num_layers);
+    for (uint32_t i = 0; i < header.num_layers; ++i)
+    {
+        int32_t size;
+        std::memcpy(&size, file->data() + sizeof(header) + i * sizeof(int32_t), sizeof(size));
+        if (size <= 0)
+        {
+            std::cerr << "Corrupt model architecture: " << filename << std::endl;
+            return nullptr;
+        }
+        arch[i] = size;
+    }
+
+    if (header.parameters_offset % WEIGHT_ALIGNMENT != 0 ||
+        header.parameters_offset + header.parameters_count * sizeof(Scalar) > file->size())
+    {
+        std::cerr << "Corrupt model parameters: " << filename << std::endl;
+        return nullptr;
+    }
+
+    // Point the network at the weights inside the mapping
+    const Scalar* weights = reinterpret_cast<const Scalar*>(file->data() + header.parameters_offset);
+    std::unique_ptr<BasicPongNeuralNetwork> network(new BasicPongNeuralNetwork(arch, file, weights));
+    if (network->parameter_count != header.parameters_count)
+    {
+        std::cerr << "Model parameter count does not match its architecture: " << filename << std::endl;
+        return nullptr;
+    }
+
+    network->mean_bally = header.mean_bally;
+    network->std_bally = header.std_bally;
+    network->mean_paddley = header.mean_paddley;
+    network->std_paddley = header.std_paddley;
+    return network;
+}
+
+
+
+// Instantiations -----------------------------------------------------------
+
+template bool BasicPongNeuralNetwork<double>::save(const std::string&) const;
+template bool BasicPongNeuralNetwork<float>::save(const std::string&) const;
+template std::unique_ptr<BasicPongNeuralNetwork<double>> BasicPongNeuralNetwork<double>::load(const std::string&);
+template std::unique_ptr<BasicPongNeuralNetwork<float>> BasicPongNeuralNetwork<float>::load(const std::string&);
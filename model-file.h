@@ -0,0 +1,49 @@
+#ifndef PONG_MODEL_FILE_H
+#define PONG_MODEL_FILE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct NormalizationParams;
+
+// Binary model file layout (native byte order):
+//
+//   ModelFileHeader
+//   int32 layer_sizes[num_layers]
+//   zero padding up to parameters_offset (a multiple of WEIGHT_ALIGNMENT)
+//   parameter block, byte for byte the network's flat weight buffer
+//
+// The parameter block keeps the in-memory per-layer alignment, so a loaded
+// network points straight into the mapped file without any parsing.
+// scalar_size records whether the weights are float or double; a file only
+// loads into the network instantiation with the same scalar type.
+
+const char MODEL_FILE_MAGIC[8] = {'P', 'O', 'N', 'G', 'N', 'E', 'T', '\0'};
+const uint32_t MODEL_FILE_VERSION = 1;
+
+struct ModelFileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t scalar_size;
+    uint32_t num_layers;
+    uint32_t reserved;
+
+    // Normalization parameters
+    double mean_bally;
+    double std_bally;
+    double mean_paddley;
+    double std_paddley;
+
+    // Byte offset and element count of the parameter block
+    uint64_t parameters_offset;
+    uint64_t parameters_count;
+};
+
+// Write a model file for any network using the flat aligned parameter
+// layout. parameters holds count values of scalar_size bytes each.
+bool write_model_file(const std::string& filename, const std::vector<int>& arch, const NormalizationParams& normalization,
+                      const void* parameters, uint64_t count, uint32_t scalar_size);
+
+#endif
@@ -1,249 +1,463 @@
 #include "config.h"
 #include "network.h"
+#include "thread-pool.h"
+#include "mapped-file.h"
+#include "scratch-arena.h"
+#include "policy-table.h"
+#include "training-metrics.h"
+#include <atomic>
+#include <chrono>
 
 // Constructors--------------------------------------------
 
+// Distinct seed for every network that is not given one. Opening a
+// std::random_device was most of the cost of copying a network, so it is
+// read once and mixed with a counter.
+static unsigned fresh_seed()
+{
+    static const unsigned base = std::random_device()();
+    static std::atomic<unsigned> counter{0};
+    return base ^ (counter.fetch_add(1, std::memory_order_relaxed) * 0x9e3779b9u);
+}
+
 // define network architecture
-PongNeuralNetwork::PongNeuralNetwork(const std::vector<int>& arch) : layer_sizes(arch), gen(rd()), dis(-1.0, 1.0)
+template <typename Scalar>
+BasicPongNeuralNetwork<Scalar>::BasicPongNeuralNetwork(const std::vector<int>& arch) : BasicPongNeuralNetwork(arch, fresh_seed())
+{
+}
+
+// define network architecture with a reproducible seed
+template <typename Scalar>
+BasicPongNeuralNetwork<Scalar>::BasicPongNeuralNetwork(const std::vector<int>& arch, unsigned seed) : layer_sizes(arch), gen(seed), dis(-1.0, 1.0)
 {
+    allocate_parameters();
+
     // Initialize weights and biases with rand values
     for (size_t i = 0; i < layer_sizes.size() - 1; ++i)
     {
-        std::vector<std::vector<double>> layer_weights;
-        for (int j = 0; j < layer_sizes[i + 1]; ++j)
+        // Xavier/Glorot initialization
+        double scale = std::sqrt(2.0 / (layer_sizes[i] + layer_sizes[i+1]));
+        Scalar* w = mutable_layer_weights(i);
+        for (int j = 0; j < layer_sizes[i + 1] * layer_sizes[i]; ++j)
         {
-            std::vector<double> neuron_weights;
-            for (int k = 0; k < layer_sizes[i]; ++k)
-            {
-                // Xavier/Glorot initialization
-                double scale = std::sqrt(2.0 / (layer_sizes[i] + layer_sizes[i+1]));
-                neuron_weights.push_back(dis(gen) * scale);
-            }
-            layer_weights.push_back(neuron_weights);
+            w[j] = static_cast<Scalar>(dis(gen) * scale);
         }
-        weights.push_back(layer_weights);
 
         // Biases for each neuron in the layer
-        std::vector<double> layer_biases;
+        Scalar* b = mutable_layer_biases(i);
         for (int j = 0; j < layer_sizes[i + 1]; ++j)
         {
-            layer_biases.push_back(dis(gen));
+            b[j] = static_cast<Scalar>(dis(gen));
         }
-        biases.push_back(layer_biases);
     }
 }
 
-// Copy constructor for PongNeuralNetwork
-PongNeuralNetwork::PongNeuralNetwork(PongNeuralNetwork& net) 
-    : layer_sizes(net.layer_sizes),  // Copy layer architecture
-    gen(rd()),                     // Initialize random generator
-    dis(-1.0, 1.0)                 // Maintain distribution range
+// Copy constructor for BasicPongNeuralNetwork
+template <typename Scalar>
+BasicPongNeuralNetwork<Scalar>::BasicPongNeuralNetwork(const BasicPongNeuralNetwork& net)
+    : mean_bally(net.mean_bally), std_bally(net.std_bally),  // Inputs are scaled the same way
+    mean_paddley(net.mean_paddley), std_paddley(net.std_paddley),
+    layer_sizes(net.layer_sizes),  // Copy layer architecture
+    parameters(net.parameters),    // Weights and biases are one flat block
+    weight_offsets(net.weight_offsets),
+    bias_offsets(net.bias_offsets),
+    parameter_count(net.parameter_count),
+    mapped_file(net.mapped_file),  // Mapped weights are shared, not copied
+    mapped_parameters(net.mapped_parameters),
+    weights_version(net.weights_version),
+    policy_table(net.policy_table),  // Same weights, so the table is shared too
+    policy_table_version(net.policy_table_version),
+    policy_table_enabled(net.policy_table_enabled),
+    policy_table_threads(net.policy_table_threads),
+    gen(fresh_seed()),             // Initialize random generator
+    dis(-1.0, 1.0),                // Maintain distribution range
+    math_mode(net.math_mode)
 {
-    // Deep copy weights
-    weights.clear();
-    for (const auto& layer_weight : net.weights) {
-        std::vector<std::vector<double>> copied_layer_weights;
-        for (const auto& neuron_weights : layer_weight) {
-            copied_layer_weights.push_back(neuron_weights);
-        }
-        weights.push_back(copied_layer_weights);
-    }
+}
 
-    // Deep copy biases
-    biases.clear();
-    for (const auto& layer_bias : net.biases) {
-        biases.push_back(layer_bias);
+// Copy assignment, same semantics as the copy constructor
+template <typename Scalar>
+BasicPongNeuralNetwork<Scalar>& BasicPongNeuralNetwork<Scalar>::operator=(const BasicPongNeuralNetwork& net)
+{
+    if (this != &net)
+    {
+        *this = BasicPongNeuralNetwork(net);
     }
+    return *this;
+}
 
-    // Optional: Copy layer outputs if needed
-    layer_outputs.clear();
-    for (const auto& layer_output : net.layer_outputs) {
-        layer_outputs.push_back(layer_output);
+// Network over weights mapped from a model file
+template <typename Scalar>
+BasicPongNeuralNetwork<Scalar>::BasicPongNeuralNetwork(const std::vector<int>& arch, std::shared_ptr<const MappedFile> file, const Scalar* weights)
+    : layer_sizes(arch), mapped_file(std::move(file)), mapped_parameters(weights), gen(fresh_seed()), dis(-1.0, 1.0)
+{
+    layout_parameters();
+}
+
+// Convert another instantiation, rounding every weight to this scalar type
+template <typename Scalar>
+template <typename Other>
+BasicPongNeuralNetwork<Scalar>::BasicPongNeuralNetwork(const BasicPongNeuralNetwork<Other>& net)
+    : mean_bally(net.mean_bally), std_bally(net.std_bally),
+    mean_paddley(net.mean_paddley), std_paddley(net.std_paddley),
+    layer_sizes(net.layer_sizes),
+    gen(fresh_seed()),
+    dis(-1.0, 1.0),
+    math_mode(net.math_mode)
+{
+    allocate_parameters();
+    for (size_t i = 0; i < layer_sizes.size() - 1; ++i)
+    {
+        std::copy_n(net.layer_weights(i), static_cast<size_t>(layer_sizes[i + 1]) * layer_sizes[i], mutable_layer_weights(i));
+        std::copy_n(net.layer_biases(i), layer_sizes[i + 1], mutable_layer_biases(i));
     }
 }
 
+// Compute the flat parameter layout, keeping every block cache line aligned
+template <typename Scalar>
+void BasicPongNeuralNetwork<Scalar>::layout_parameters()
+{
+    size_t offset = 0;
+    weight_offsets.clear();
+    bias_offsets.clear();
 
+    for (size_t i = 0; i < layer_sizes.size() - 1; ++i)
+    {
+        weight_offsets.push_back(offset);
+        offset += aligned_size<Scalar>(static_cast<size_t>(layer_sizes[i + 1]) * layer_sizes[i]);
 
-// Helper Functions----------------------------------------
+        bias_offsets.push_back(offset);
+        offset += aligned_size<Scalar>(layer_sizes[i + 1]);
+    }
 
-// Activation function (tanh)
-double PongNeuralNetwork::activation_tanh(double x)
+    parameter_count = offset;
+}
+
+// Allocate an owned, zeroed parameter buffer
+template <typename Scalar>
+void BasicPongNeuralNetwork<Scalar>::allocate_parameters()
 {
-    return std::tanh(x);
+    layout_parameters();
+    parameters.assign(parameter_count, Scalar(0));
 }
 
-// Derivative of tanh for backpropagation
-double PongNeuralNetwork::tanh_derivative(double x)
+// Copy on write for mapped models
+template <typename Scalar>
+void BasicPongNeuralNetwork<Scalar>::detach_parameters()
 {
-    double tanh_x = std::tanh(x);
-    return 1.0 - tanh_x * tanh_x;
+    if (mapped_parameters)
+    {
+        parameters.assign(mapped_parameters, mapped_parameters + parameter_count);
+        mapped_parameters = nullptr;
+        mapped_file.reset();
+    }
 }
 
-// Softmax for the output layer to get probability dist
-std::vector<double> PongNeuralNetwork::softmax(const std::vector<double>& input)
+
+
+// Helper Functions----------------------------------------
+
+// Propagation through net ----------------------------------------------
+
+// Forward pass that only touches the workspace, so it is safe to run concurrently
+template <typename Scalar>
+const Scalar* BasicPongNeuralNetwork<Scalar>::infer(const GameState& state, Workspace& workspace) const
 {
-    std::vector<double> output(input.size());
-    double mal_val = *std::max_element(input.begin(), input.end());
-    double exp_sum = 0.0;
+    Scalar* current = workspace.current.data();
+    Scalar* next = workspace.next.data();
 
-    // Compute exponentials and sum
-    for (size_t i = 0; i < input.size(); ++i)
+    // Features beyond the ones supplied feed the input layer as zeros
+    std::fill_n(current, layer_sizes[0], Scalar(0));
+    normalize_input(state, current);
+
+    for (size_t i = 0; i < layer_sizes.size() - 1; ++i)
     {
-        output[i] = std::exp(input[i] - mal_val);
-        exp_sum += output[i];
+        dense_forward(layer_weights(i), layer_biases(i), current, next, layer_sizes[i + 1], layer_sizes[i]);
+
+        if (i != layer_sizes.size() - 2)
+        {
+            tanh_inplace(next, layer_sizes[i + 1], math_mode);
+        }
+        std::swap(current, next);
     }
 
-    // Normalize
-    for (double& val : output)
+    return current;
+}
+
+// Fused training step, the activations of the single forward pass stay in
+// the arena for the backward pass and the update
+template <typename Scalar>
+void BasicPongNeuralNetwork<Scalar>::train_step(const GameState& state, int target, Scalar learning_rate, ScratchArena& arena, EpochStats& stats)
+{
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point forward_start, backward_start, update_start;
+    if (stats.detailed)
     {
-        val /= exp_sum;
+        forward_start = Clock::now();
     }
 
-    return output;
-}
+    arena.reset();
+    const size_t last = layer_sizes.size() - 1;
+    Scalar** activations = arena.allocate<Scalar*>(layer_sizes.size());
+    Scalar** deltas = arena.allocate<Scalar*>(layer_sizes.size());
+    for (size_t i = 0; i < layer_sizes.size(); ++i)
+    {
+        activations[i] = arena.allocate<Scalar>(layer_sizes[i]);
+        deltas[i] = arena.allocate<Scalar>(layer_sizes[i]);
+    }
 
+    // Features beyond the ones supplied feed the input layer as zeros
+    std::fill_n(activations[0], layer_sizes[0], Scalar(0));
+    normalize_input(state, activations[0]);
 
+    // Forward pass, tanh on hidden layers
+    for (size_t i = 0; i < last; ++i)
+    {
+        dense_forward(layer_weights(i), layer_biases(i), activations[i], activations[i + 1], layer_sizes[i + 1], layer_sizes[i]);
 
-// Propagation through net ----------------------------------------------
+        if (i + 1 != last)
+        {
+            tanh_inplace(activations[i + 1], layer_sizes[i + 1], math_mode);
+        }
+    }
 
-// Forward propagation with storage of layer outputs
-std::vector<double> PongNeuralNetwork::forward_propagate(const std::vector<double>& input)
-{
-    layer_outputs.clear();
-    layer_outputs.push_back(input);
+    // Softmax cross entropy, the output delta is probabilities minus target
+    const int outputs = layer_sizes.back();
+    Scalar* output = activations[last];
+    softmax_inplace(output, outputs, math_mode);
+    stats.total_loss += -std::log(std::max<double>(output[target], 1e-15));
+    for (int j = 0; j < outputs; ++j)
+    {
+        deltas[last][j] = output[j] - (j == target ? Scalar(1) : Scalar(0));
 
-    std::vector<double> layer_output = input;
+        // Track gradient magnitude
+        stats.max_gradient = std::max<double>(stats.max_gradient, std::abs(deltas[last][j]));
+        stats.min_gradient = std::min<double>(stats.min_gradient, std::abs(deltas[last][j]));
+    }
 
-    // Propagate through hidden layers
-    for (size_t i = 0; i < layer_sizes.size() - 1; ++i) {
-        std::vector<double> next_layer(layer_sizes[i + 1], 0.0);
+    if (stats.detailed)
+    {
+        backward_start = Clock::now();
+    }
 
-        // Compute next layer activations
-        for (int j = 0; j < layer_sizes[i + 1]; ++j) {
-            for (int k = 0; k < layer_sizes[i]; ++k) {
-                next_layer[j] += weights[i][j][k] * layer_output[k];
-            }
-            next_layer[j] += biases[i][j];
+    // Backpropagate the gradient (the input layer has no delta to compute)
+    for (size_t layer = last - 1; layer >= 1; --layer)
+    {
+        dense_backward(layer_weights(layer), deltas[layer + 1], deltas[layer], layer_sizes[layer + 1], layer_sizes[layer]);
+
+        // tanh'(x) = 1 - tanh(x)^2, and the stored activation already is tanh(x)
+        for (int neuron = 0; neuron < layer_sizes[layer]; ++neuron)
+        {
+            Scalar a = activations[layer][neuron];
+            deltas[layer][neuron] *= Scalar(1) - a * a;
         }
+    }
 
-        // Use tanh for hidden layers, softmax for output
-        if (i != layer_sizes.size() - 2)
+    if (stats.detailed)
+    {
+        update_start = Clock::now();
+    }
+
+    // Update weights and biases
+    for (size_t layer = 0; layer < last; ++layer)
+    {
+        dense_update(mutable_layer_weights(layer), mutable_layer_biases(layer), deltas[layer + 1],
+                     activations[layer], learning_rate, layer_sizes[layer + 1], layer_sizes[layer]);
+    }
+
+    if (stats.detailed)
+    {
+        Clock::time_point update_end = Clock::now();
+        stats.forward_seconds += std::chrono::duration<double>(backward_start - forward_start).count();
+        stats.backward_seconds += std::chrono::duration<double>(update_start - backward_start).count();
+        stats.update_seconds += std::chrono::duration<double>(update_end - update_start).count();
+
+        // The weight gradient is an outer product, so its squared norm is
+        // |delta|^2 |input|^2, plus |delta|^2 for the biases
+        for (size_t layer = 0; layer < last; ++layer)
         {
-            for (auto& val : next_layer)
+            double delta_sq = 0.0, input_sq = 0.0;
+            for (int j = 0; j < layer_sizes[layer + 1]; ++j)
             {
-                val = activation_tanh(val);
+                delta_sq += static_cast<double>(deltas[layer + 1][j]) * deltas[layer + 1][j];
             }
+            for (int k = 0; k < layer_sizes[layer]; ++k)
+            {
+                input_sq += static_cast<double>(activations[layer][k]) * activations[layer][k];
+            }
+            stats.gradient_sq[layer] += delta_sq * (input_sq + 1.0);
         }
-
-        // Store layer output
-        layer_outputs.push_back(next_layer);
-        layer_output = next_layer;
     }
+}
 
-    // Apply softmax to output layer
-    return softmax(layer_output);
+
+
+// Mini-batch propagation -----------------------------------------------
+
+// Size the batch buffers, only reallocating when the batch grows
+template <typename Scalar>
+void BasicPongNeuralNetwork<Scalar>::prepare_batch_workspace(BatchWorkspace& workspace, int batch) const
+{
+    workspace.activations.resize(layer_sizes.size());
+    workspace.deltas.resize(layer_sizes.size());
+    for (size_t i = 0; i < layer_sizes.size(); ++i)
+    {
+        size_t needed = static_cast<size_t>(batch) * layer_sizes[i];
+        if (workspace.activations[i].size() < needed)
+        {
+            workspace.activations[i].resize(needed);
+            workspace.deltas[i].resize(needed);
+        }
+    }
+    workspace.gradients.resize(parameter_count);
 }
 
-// Back propagateion
-void PongNeuralNetwork::backpropagate(const std::vector<double>& input, const std::vector<double>& output_gradient, double learning_rate)
+// Push a whole batch through the network as matrices and accumulate gradients
+template <typename Scalar>
+void BasicPongNeuralNetwork<Scalar>::accumulate_batch_gradients(const TrainingView& training_data, const int* indices, int count, BatchWorkspace& workspace, EpochStats& stats) const
 {
-    // Re-run forward propagation to refresh layer outputs
-    forward_propagate(input);
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point forward_start, backward_start;
+    if (stats.detailed)
+    {
+        forward_start = Clock::now();
+    }
 
-    // Initialize delta (gradient) for each layer
-    std::vector<std::vector<double>> layer_deltas(layer_sizes.size());
+    const size_t last = layer_sizes.size() - 1;
 
-    // Output layer delta (already computed in the gradient passed in)
-    layer_deltas.back() = output_gradient;
+    // Gather normalized inputs into the first activation matrix
+    Scalar* input = workspace.activations[0].data();
+    std::fill_n(input, static_cast<size_t>(count) * layer_sizes[0], Scalar(0));
+    for (int n = 0; n < count; ++n)
+    {
+        normalize_input({training_data.bally_at(indices[n]), training_data.paddley_at(indices[n])},
+                        input + static_cast<size_t>(n) * layer_sizes[0]);
+    }
 
-    // Backpropagate the gradient
-    for (int layer = layer_sizes.size() - 2; layer >= 0; --layer)
+    // Forward pass, tanh on hidden layers
+    for (size_t i = 0; i < last; ++i)
     {
-        // Resize delta for current layer
-        layer_deltas[layer].resize(layer_sizes[layer]);
+        Scalar* output = workspace.activations[i + 1].data();
+        dense_forward_batch(layer_weights(i), layer_biases(i), workspace.activations[i].data(), output,
+                            count, layer_sizes[i + 1], layer_sizes[i]);
 
-        // Compute delta for each neuron in the current layer
-        for (int neuron = 0; neuron < layer_sizes[layer]; ++neuron)
+        if (i + 1 != last)
         {
-            double delta = 0.0;
-            
-            // Compute gradient based on next layer's deltas
-            for (int next_neuron = 0; next_neuron < layer_sizes[layer + 1]; ++next_neuron)
-            {
-                delta += layer_deltas[layer + 1][next_neuron] * weights[layer][next_neuron][neuron];
-            }
+            tanh_inplace(output, static_cast<size_t>(count) * layer_sizes[i + 1], math_mode);
+        }
+    }
 
-            // Apply activation derivative
-            delta *= tanh_derivative(layer_outputs[layer][neuron]);
+    // Softmax cross entropy, the output delta is probabilities minus target
+    const int outputs = layer_sizes.back();
+    for (int n = 0; n < count; ++n)
+    {
+        Scalar* logits = workspace.activations[last].data() + static_cast<size_t>(n) * outputs;
+        Scalar* delta = workspace.deltas[last].data() + static_cast<size_t>(n) * outputs;
+        softmax_inplace(logits, outputs, math_mode);
 
-            layer_deltas[layer][neuron] = delta;
+        int target = training_data.moves[indices[n]];
+        stats.total_loss += -std::log(std::max<double>(logits[target], 1e-15));
+        for (int j = 0; j < outputs; ++j)
+        {
+            delta[j] = logits[j] - (j == target ? Scalar(1) : Scalar(0));
+            stats.max_gradient = std::max<double>(stats.max_gradient, std::abs(delta[j]));
+            stats.min_gradient = std::min<double>(stats.min_gradient, std::abs(delta[j]));
         }
     }
 
-    // Update weights and biases
-    for (size_t layer = 0; layer < layer_sizes.size() - 1; ++layer)
+    if (stats.detailed)
     {
-        for (int next_neuron = 0; next_neuron < layer_sizes[layer + 1]; ++next_neuron)
-        {
-            for (int current_neuron = 0; current_neuron < layer_sizes[layer]; ++current_neuron)
-            {
-                // Weight update
-                weights[layer][next_neuron][current_neuron] -= 
-                    learning_rate * layer_deltas[layer + 1][next_neuron] * layer_outputs[layer][current_neuron];
-            }
+        backward_start = Clock::now();
+    }
+
+    // Backward pass through the hidden layers (the input layer has no delta)
+    for (size_t layer = last - 1; layer >= 1; --layer)
+    {
+        Scalar* delta = workspace.deltas[layer].data();
+        dense_backward_batch(layer_weights(layer), workspace.deltas[layer + 1].data(), delta,
+                             count, layer_sizes[layer + 1], layer_sizes[layer]);
 
-            // Bias update
-            biases[layer][next_neuron] -= 
-                learning_rate * layer_deltas[layer + 1][next_neuron];
+        const Scalar* activation = workspace.activations[layer].data();
+        for (size_t j = 0; j < static_cast<size_t>(count) * layer_sizes[layer]; ++j)
+        {
+            delta[j] *= Scalar(1) - activation[j] * activation[j];
         }
     }
+
+    // Weight and bias gradients for every layer
+    for (size_t layer = 0; layer < last; ++layer)
+    {
+        dense_gradient_batch(workspace.deltas[layer + 1].data(), workspace.activations[layer].data(),
+                             workspace.gradients.data() + weight_offsets[layer],
+                             workspace.gradients.data() + bias_offsets[layer],
+                             count, layer_sizes[layer + 1], layer_sizes[layer]);
+    }
+
+    if (stats.detailed)
+    {
+        Clock::time_point backward_end = Clock::now();
+        stats.forward_seconds += std::chrono::duration<double>(backward_start - forward_start).count();
+        stats.backward_seconds += std::chrono::duration<double>(backward_end - backward_start).count();
+    }
 }
 
 
 
 // Input preparation -----------------------------------------------------
 
-// Compute normalization parameters from training data
-void PongNeuralNetwork::compute_normalization_params(const std::vector<GameState>& training_data)
+// Mean and standard deviation of both inputs
+NormalizationParams compute_normalization(const TrainingView& training_data)
 {
     // Reset sums and counts
     double sum_bally = 0.0;
     double sum_paddley = 0.0;
-    size_t n = training_data.size();
+    size_t n = training_data.size;
 
     // Compute means
-    for (const auto& state : training_data) {
-        sum_bally += state.bally;
-        sum_paddley += state.paddley;
+    for (size_t i = 0; i < n; ++i) {
+        sum_bally += training_data.bally_at(i);
+        sum_paddley += training_data.paddley_at(i);
     }
 
-    mean_bally = sum_bally / n;
-    mean_paddley = sum_paddley / n;
+    NormalizationParams params;
+    params.mean_bally = sum_bally / n;
+    params.mean_paddley = sum_paddley / n;
 
     // Compute standard deviations
     double var_bally = 0.0;
     double var_paddley = 0.0;
 
-    for (const auto& state : training_data) {
-        var_bally += std::pow(state.bally - mean_bally, 2);
-        var_paddley += std::pow(state.paddley - mean_paddley, 2);
+    for (size_t i = 0; i < n; ++i) {
+        var_bally += std::pow(training_data.bally_at(i) - params.mean_bally, 2);
+        var_paddley += std::pow(training_data.paddley_at(i) - params.mean_paddley, 2);
     }
 
-    std_bally = std::sqrt(var_bally / n);
-    std_paddley = std::sqrt(var_paddley / n);
+    params.std_bally = std::sqrt(var_bally / n);
+    params.std_paddley = std::sqrt(var_paddley / n);
 
     // Prevent division by zero
-    std_bally = std_bally > 0 ? std_bally : 1.0;
-    std_paddley = std_paddley > 0 ? std_paddley : 1.0;
+    params.std_bally = params.std_bally > 0 ? params.std_bally : 1.0;
+    params.std_paddley = params.std_paddley > 0 ? params.std_paddley : 1.0;
+    return params;
 }
 
-// Normalize input
-std::vector<double> PongNeuralNetwork::normalize_input(const GameState& state)
+// Compute normalization parameters from training data
+template <typename Scalar>
+void BasicPongNeuralNetwork<Scalar>::compute_normalization_params(const TrainingView& training_data)
 {
-    return {
-        (state.bally - mean_bally) / std_bally,
-        (state.paddley - mean_paddley) / std_paddley
-    };
+    NormalizationParams params = compute_normalization(training_data);
+    mean_bally = params.mean_bally;
+    std_bally = params.std_bally;
+    mean_paddley = params.mean_paddley;
+    std_paddley = params.std_paddley;
+}
+
+// Normalize input into a preallocated buffer
+template <typename Scalar>
+void BasicPongNeuralNetwork<Scalar>::normalize_input(const GameState& state, Scalar* out) const
+{
+    out[0] = static_cast<Scalar>((state.bally - mean_bally) / std_bally);
+    out[1] = static_cast<Scalar>((state.paddley - mean_paddley) / std_paddley);
 }
 
 
@@ -251,68 +465,433 @@ std::vector<double> PongNeuralNetwork::normalize_input(const GameState& state)
 
 // Public Net functions ---------------------------------------------------
 
+// Size the workspace buffers to the widest layer
+template <typename Scalar>
+void BasicPongNeuralNetwork<Scalar>::prepare_workspace(Workspace& workspace) const
+{
+    size_t widest = std::max<size_t>(2, *std::max_element(layer_sizes.begin(), layer_sizes.end()));
+    if (workspace.current.size() < widest)
+    {
+        workspace.current.resize(widest);
+        workspace.next.resize(widest);
+    }
+}
+
 // Predict optimal paddle movement based on state
-int PongNeuralNetwork::predict_move(GameState gamestate)
+template <typename Scalar>
+int BasicPongNeuralNetwork<Scalar>::predict_move(const GameState& gamestate, Workspace& workspace) const
 {
-    GameState state{static_cast<double>(gamestate.bally),
-                    static_cast<double>(gamestate.paddley)};
-    
-    std::vector<double> input = normalize_input(state);
-    std::vector<double> output = forward_propagate(input); 
+    if (const PolicyTable* table = current_policy_table())
+    {
+        int move = table->lookup(gamestate);
+        if (move >= 0)
+        {
+            return move;
+        }
+    }
+
+    prepare_workspace(workspace);
+    const Scalar* logits = infer(gamestate, workspace);
 
-    int movement = std::max_element(output.begin(), output.end()) - output.begin();
+    int movement = std::max_element(logits, logits + layer_sizes.back()) - logits;
     return movement;
 }
 
+// Predict using a workspace owned by the calling thread
+template <typename Scalar>
+int BasicPongNeuralNetwork<Scalar>::predict_move(const GameState& gamestate) const
+{
+    thread_local Workspace workspace;
+    return predict_move(gamestate, workspace);
+}
+
+// Samples pushed through the layers together by predict_moves
+const int INFERENCE_CHUNK = 64;
+
+// Batched prediction, from the policy table when there is a current one
+template <typename Scalar>
+void BasicPongNeuralNetwork<Scalar>::predict_moves(const int* bally, const int* paddley, int* moves, int count, BatchInferenceWorkspaceType& workspace) const
+{
+    const PolicyTable* table = current_policy_table();
+    if (!table)
+    {
+        infer_moves(bally, paddley, moves, count, workspace);
+        return;
+    }
+
+    for (int n = 0; n < count; ++n)
+    {
+        moves[n] = table->lookup({bally[n], paddley[n]});
+        if (moves[n] < 0)
+        {
+            infer_moves(bally + n, paddley + n, moves + n, 1, workspace);
+        }
+    }
+}
+
+// Policy table ------------------------------------------------------------
+
+template <typename Scalar>
+const PolicyTable* BasicPongNeuralNetwork<Scalar>::current_policy_table() const
+{
+    return policy_table && policy_table_version == weights_version ? policy_table.get() : nullptr;
+}
+
+template <typename Scalar>
+void BasicPongNeuralNetwork<Scalar>::enable_policy_table(bool enabled, int num_threads)
+{
+    policy_table_enabled = enabled;
+    policy_table_threads = num_threads;
+    if (!enabled)
+    {
+        policy_table.reset();
+    }
+    else if (!current_policy_table())
+    {
+        rebuild_policy_table();
+    }
+}
+
+template <typename Scalar>
+size_t BasicPongNeuralNetwork<Scalar>::policy_table_bytes() const
+{
+    const PolicyTable* table = current_policy_table();
+    return table ? table->bytes() : 0;
+}
+
+template <typename Scalar>
+void BasicPongNeuralNetwork<Scalar>::set_math_mode(MathMode mode)
+{
+    if (mode == math_mode)
+    {
+        return;
+    }
+
+    math_mode = mode;
+    ++weights_version;
+    if (policy_table_enabled)
+    {
+        rebuild_policy_table();
+    }
+}
+
+// Take an owned copy of externally supplied weights
+template <typename Scalar>
+void BasicPongNeuralNetwork<Scalar>::set_parameters(const Scalar* values)
+{
+    parameters.assign(values, values + parameter_count);
+    mapped_parameters = nullptr;
+    mapped_file.reset();
+
+    ++weights_version;
+    if (policy_table_enabled)
+    {
+        rebuild_policy_table();
+    }
+}
+
+// Point at external weights the way a mapped model does, dropping any owned buffer
+template <typename Scalar>
+void BasicPongNeuralNetwork<Scalar>::view_parameters(const Scalar* values)
+{
+    AlignedVector<Scalar>().swap(parameters);
+    mapped_file.reset();
+    mapped_parameters = values;
+
+    ++weights_version;
+    if (policy_table_enabled)
+    {
+        rebuild_policy_table();
+    }
+}
+
+template <typename Scalar>
+void BasicPongNeuralNetwork<Scalar>::set_normalization(const NormalizationParams& params)
+{
+    mean_bally = params.mean_bally;
+    std_bally = params.std_bally;
+    mean_paddley = params.mean_paddley;
+    std_paddley = params.std_paddley;
+
+    ++weights_version;
+    if (policy_table_enabled)
+    {
+        rebuild_policy_table();
+    }
+}
+
+// Every bally row is one batched pass through the network
+template <typename Scalar>
+void BasicPongNeuralNetwork<Scalar>::rebuild_policy_table()
+{
+    auto table = std::make_shared<PolicyTable>();
+    table->build([this](int bally, int* moves) {
+        thread_local BatchInferenceWorkspaceType workspace;
+        int ballys[PolicyTable::PADDLE_POSITIONS];
+        int paddleys[PolicyTable::PADDLE_POSITIONS];
+        for (int paddley = 0; paddley < PolicyTable::PADDLE_POSITIONS; ++paddley)
+        {
+            ballys[paddley] = bally;
+            paddleys[paddley] = paddley;
+        }
+        infer_moves(ballys, paddleys, moves, PolicyTable::PADDLE_POSITIONS, workspace);
+    }, policy_table_threads);
+
+    policy_table = table;
+    policy_table_version = weights_version;
+}
+
+// Batched prediction, the argmax is taken on the logits since softmax keeps their order
+template <typename Scalar>
+void BasicPongNeuralNetwork<Scalar>::infer_moves(const int* bally, const int* paddley, int* moves, int count, BatchInferenceWorkspaceType& workspace) const
+{
+    size_t widest = std::max<size_t>(2, *std::max_element(layer_sizes.begin(), layer_sizes.end()));
+    if (workspace.current.size() < widest * INFERENCE_CHUNK)
+    {
+        workspace.current.resize(widest * INFERENCE_CHUNK);
+        workspace.next.resize(widest * INFERENCE_CHUNK);
+    }
+
+    for (int start = 0; start < count; start += INFERENCE_CHUNK)
+    {
+        int chunk = std::min(INFERENCE_CHUNK, count - start);
+        Scalar* current = workspace.current.data();
+        Scalar* next = workspace.next.data();
+
+        // Features beyond the ones supplied feed the input layer as zeros
+        std::fill_n(current, static_cast<size_t>(chunk) * layer_sizes[0], Scalar(0));
+        for (int n = 0; n < chunk; ++n)
+        {
+            normalize_input({bally[start + n], paddley[start + n]}, current + static_cast<size_t>(n) * layer_sizes[0]);
+        }
+
+        for (size_t i = 0; i < layer_sizes.size() - 1; ++i)
+        {
+            dense_forward_batch(layer_weights(i), layer_biases(i), current, next, chunk, layer_sizes[i + 1], layer_sizes[i]);
+
+            if (i != layer_sizes.size() - 2)
+            {
+                tanh_inplace(next, static_cast<size_t>(chunk) * layer_sizes[i + 1], math_mode);
+            }
+            std::swap(current, next);
+        }
+
+        const int outputs = layer_sizes.back();
+        for (int n = 0; n < chunk; ++n)
+        {
+            const Scalar* logits = current + static_cast<size_t>(n) * outputs;
+            moves[start + n] = std::max_element(logits, logits + outputs) - logits;
+        }
+    }
+}
+
 // Training the neural network
-void PongNeuralNetwork::train(const std::vector<GameState>& training_data, const std::vector<int>& expected_moves, double learning_rate, int epochs)
+template <typename Scalar>
+void BasicPongNeuralNetwork<Scalar>::train(const std::vector<GameState>& training_data, const std::vector<int>& expected_moves, double learning_rate, int epochs,
+                              const TrainOptions& options)
 {
-    compute_normalization_params(training_data);
+    // View the GameState array in place, no column copies
+    TrainingView view;
+    if (!training_data.empty())
+    {
+        view.bally = &training_data.data()->bally;
+        view.paddley = &training_data.data()->paddley;
+    }
+    view.moves = expected_moves.data();
+    view.state_stride = sizeof(GameState) / sizeof(int);
+    view.size = std::min(training_data.size(), expected_moves.size());
+    train(view, learning_rate, epochs, options);
+}
+
+// Training over a sample view
+template <typename Scalar>
+void BasicPongNeuralNetwork<Scalar>::train(const TrainingView& training_data, double learning_rate, int epochs, const TrainOptions& options)
+{
+    if (training_data.size == 0)
+    {
+        std::cerr << "No training data" << std::endl;
+        return;
+    }
+
+    if (!options.keep_normalization)
+    {
+        compute_normalization_params(training_data);
+    }
+    detach_parameters();
+
+    // Any policy table now describes old weights
+    ++weights_version;
+
+    const int batch_size = std::max(1, options.batch_size);
+    const int shard_size = std::max(1, std::min(options.shard_size, batch_size));
+    const int max_shards = (batch_size + shard_size - 1) / shard_size;
+
+    // One workspace per shard so shards can run on any thread
+    std::vector<BatchWorkspace> shard_workspaces;
+    std::vector<EpochStats> shard_stats;
+    if (batch_size > 1)
+    {
+        shard_workspaces.resize(max_shards);
+        for (auto& workspace : shard_workspaces)
+        {
+            prepare_batch_workspace(workspace, shard_size);
+        }
+    }
+    ThreadPool pool(batch_size > 1 ? options.num_threads : 1);
+
+    // Metrics go to the caller's sink or, by default, to std::cout
+    TextTrainingSink default_sink(std::cout);
+    TrainingSink& sink = options.sink ? *options.sink : default_sink;
+    const bool detailed = options.detailed_metrics;
+    const size_t weight_layers = layer_sizes.size() - 1;
+    EpochMetrics metrics;
+    metrics.epochs = epochs;
+    metrics.samples = training_data.size;
+    metrics.batch_size = batch_size;
+    metrics.threads = pool.size();
+    metrics.detailed = detailed;
+    std::vector<double> gradient_sq(detailed ? weight_layers : 0);
+    AlignedVector<Scalar> epoch_start_parameters(detailed ? parameter_count : 0);
+    if (detailed)
+    {
+        metrics.gradient_norms.resize(weight_layers);
+        metrics.update_ratios.resize(weight_layers);
+    }
+
+    // Everything the epoch loop touches is set up here, so the loop itself
+    // never allocates: the shuffle order, the per-sample arena and the
+    // shard task, which reads the current batch through batch_start/count
+    std::vector<int> indices(training_data.size);
+    ScratchArena arena;
+    size_t batch_start = 0;
+    int batch_count = 0;
+    const std::function<void(int)> shard_task = [&](int shard) {
+        BatchWorkspace& workspace = shard_workspaces[shard];
+        int offset = shard * shard_size;
+        std::fill(workspace.gradients.begin(), workspace.gradients.end(), Scalar(0));
+        accumulate_batch_gradients(training_data, indices.data() + batch_start + offset,
+                                   std::min(shard_size, batch_count - offset), workspace, shard_stats[shard]);
+    };
 
     for (int epoch = 0; epoch < epochs; ++epoch)
     {
-        double total_loss = 0.0;
-        double max_gradient = 0.0;
-        double min_gradient = std::numeric_limits<double>::max();
+        auto epoch_start = std::chrono::steady_clock::now();
+        EpochStats stats;
+        stats.detailed = detailed;
+        stats.gradient_sq = gradient_sq.data();
+        shard_stats.assign(max_shards, stats);
+        std::fill(gradient_sq.begin(), gradient_sq.end(), 0.0);
+        std::copy(parameters.begin(), parameters.begin() + epoch_start_parameters.size(), epoch_start_parameters.begin());
+        long updates = 0;
 
         // Shuffle the training data
-        std::vector<int> indices(training_data.size());
         std::iota(indices.begin(), indices.end(), 0);
         std::shuffle(indices.begin(), indices.end(), gen);
 
-        for (size_t i = 0; i < training_data.size(); ++i)
+        if (batch_size > 1)
         {
-            int index = indices[i];
-            std::vector<double> input = normalize_input(training_data[index]);
-            std::vector<double> output = forward_propagate(input); 
-
-            // Compute target
-            std::vector<double> target(output.size(), 0.0);
-            target[expected_moves[index]] = 1.0;
-
-            // Compute loss
-            std::vector<double> loss(output.size());
-            for (size_t j = 0; j < output.size(); ++j)
+            // Mini-batch: one averaged update per batch
+            for (batch_start = 0; batch_start < training_data.size; batch_start += batch_size)
             {
-                loss[j] = -target[j] * std::log(std::max(output[j], 1e-15));
-                total_loss += loss[j];
+                batch_count = static_cast<int>(std::min<size_t>(batch_size, training_data.size - batch_start));
+                int shards = (batch_count + shard_size - 1) / shard_size;
+
+                // Each shard computes gradients for its slice into its own buffer
+                pool.parallel_for(shards, shard_task);
+                auto update_start = std::chrono::steady_clock::now();
+
+                // Reduce in shard order so the sum never depends on scheduling
+                AlignedVector<Scalar>& gradients = shard_workspaces[0].gradients;
+                for (int shard = 1; shard < shards; ++shard)
+                {
+                    scaled_add(Scalar(1), shard_workspaces[shard].gradients.data(), gradients.data(), gradients.size());
+                }
+                scaled_add(static_cast<Scalar>(-learning_rate / batch_count), gradients.data(), parameters.data(), parameter_count);
+
+                if (detailed)
+                {
+                    stats.update_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - update_start).count();
+
+                    // Norm of the averaged gradient, weight and bias blocks
+                    // of a layer are contiguous and their padding stays zero
+                    for (size_t layer = 0; layer < weight_layers; ++layer)
+                    {
+                        size_t end = layer + 1 < weight_layers ? weight_offsets[layer + 1] : parameter_count;
+                        double sum_sq = 0.0;
+                        for (size_t k = weight_offsets[layer]; k < end; ++k)
+                        {
+                            sum_sq += static_cast<double>(gradients[k]) * gradients[k];
+                        }
+                        gradient_sq[layer] += sum_sq / (static_cast<double>(batch_count) * batch_count);
+                    }
+                }
+                ++updates;
             }
 
-            // Compute gradients
-            std::vector<double> gradient = output;
-            for (size_t j = 0; j < output.size(); ++j)
+            for (const auto& shard : shard_stats)
+            {
+                stats.total_loss += shard.total_loss;
+                stats.max_gradient = std::max(stats.max_gradient, shard.max_gradient);
+                stats.min_gradient = std::min(stats.min_gradient, shard.min_gradient);
+                stats.forward_seconds += shard.forward_seconds;
+                stats.backward_seconds += shard.backward_seconds;
+            }
+        }
+        else
+        {
+            for (size_t i = 0; i < training_data.size; ++i)
             {
-                gradient[j] -= target[j];
-                
-                // Track gradient magnitude
-                max_gradient = std::max(max_gradient, std::abs(gradient[j]));
-                min_gradient = std::min(min_gradient, std::abs(gradient[j]));
+                int index = indices[i];
+                train_step({training_data.bally_at(index), training_data.paddley_at(index)}, training_data.moves[index],
+                           static_cast<Scalar>(learning_rate), arena, stats);
             }
+            updates = static_cast<long>(training_data.size);
+        }
 
-            // Backpropagate and update weights and biases
-            backpropagate(input, gradient, learning_rate);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - epoch_start).count();
+
+        metrics.epoch = epoch + 1;
+        metrics.loss = stats.total_loss / training_data.size;
+        metrics.max_gradient = stats.max_gradient;
+        metrics.min_gradient = stats.min_gradient;
+        metrics.seconds = seconds;
+        metrics.samples_per_second = training_data.size / std::max(seconds, 1e-9);
+        if (detailed)
+        {
+            metrics.forward_seconds = stats.forward_seconds;
+            metrics.backward_seconds = stats.backward_seconds;
+            metrics.update_seconds = stats.update_seconds;
+            for (size_t layer = 0; layer < weight_layers; ++layer)
+            {
+                metrics.gradient_norms[layer] = std::sqrt(gradient_sq[layer] / std::max(updates, 1L));
+
+                // Weights only, the biases are left out of the ratio
+                const Scalar* before = epoch_start_parameters.data() + weight_offsets[layer];
+                const Scalar* after = parameters.data() + weight_offsets[layer];
+                double change_sq = 0.0, weight_sq = 0.0;
+                for (size_t k = 0; k < static_cast<size_t>(layer_sizes[layer + 1]) * layer_sizes[layer]; ++k)
+                {
+                    change_sq += static_cast<double>(after[k] - before[k]) * (after[k] - before[k]);
+                    weight_sq += static_cast<double>(before[k]) * before[k];
+                }
+                metrics.update_ratios[layer] = weight_sq > 0.0 ? std::sqrt(change_sq / weight_sq) : 0.0;
+            }
         }
+        sink.epoch(metrics);
+    }
+    sink.finish();
 
-        std::cout << "Epoch " << epoch + 1 << "/" << epochs << " - Loss: " << total_loss / training_data.size() << " - Max Gradient: " << max_gradient << " - Min Gradient: " << min_gradient << std::endl;
+    if (policy_table_enabled)
+    {
+        rebuild_policy_table();
     }
-}
\ No newline at end of file
+}
+
+
+
+// Instantiations -----------------------------------------------------------
+
+template class BasicPongNeuralNetwork<double>;
+template class BasicPongNeuralNetwork<float>;
+template BasicPongNeuralNetwork<double>::BasicPongNeuralNetwork(const BasicPongNeuralNetwork<float>&);
+template BasicPongNeuralNetwork<float>::BasicPongNeuralNetwork(const BasicPongNeuralNetwork<double>&);
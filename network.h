@@ -9,55 +9,310 @@
 #include <string>
 #include <random>
 #include <algorithm>
+#include <limits>
+#include <memory>
+#include "dense-kernels.h"
+#include "fast-math.h"
 
 struct GameState;
+class MappedFile;
+class ScratchArena;
+class PolicyTable;
+class TrainingSink;
+
+// Scratch buffers for allocation free inference. One workspace per thread
+// lets any number of threads share a single trained network.
+template <typename Scalar>
+struct BasicInferenceWorkspace
+{
+    std::vector<Scalar> current;
+    std::vector<Scalar> next;
+};
+
+// Scratch matrices for batched inference over many games at once
+template <typename Scalar>
+struct BasicBatchInferenceWorkspace
+{
+    AlignedVector<Scalar> current;
+    AlignedVector<Scalar> next;
+};
+
+using InferenceWorkspace = BasicInferenceWorkspace<double>;
+using BatchInferenceWorkspace = BasicBatchInferenceWorkspace<double>;
+
+// Read only view of training samples. bally and paddley advance by
+// state_stride ints per sample (2 when viewing a GameState array, 1 for
+// separate columns), moves are contiguous.
+struct TrainingView
+{
+    const int* bally = nullptr;
+    const int* paddley = nullptr;
+    const int* moves = nullptr;
+    size_t state_stride = 1;
+    size_t size = 0;
+
+    int bally_at(size_t i) const { return bally[i * state_stride]; }
+    int paddley_at(size_t i) const { return paddley[i * state_stride]; }
+};
+
+// Knobs for train beyond learning rate and epochs
+struct TrainOptions
+{
+    // Samples per weight update. 1 keeps per-sample SGD, larger batches
+    // average the gradient over the batch and update weights once.
+    int batch_size = 1;
+
+    // Threads computing gradients in mini-batch mode (<= 0 uses all cores)
+    int num_threads = 1;
+
+    // Samples per gradient shard. Shards are reduced in a fixed order, so
+    // for a given seed the loss curve is identical for any thread count.
+    int shard_size = 16;
+
+    // Receives per-epoch metrics, nullptr prints them to std::cout
+    TrainingSink* sink = nullptr;
+
+    // Also time the forward, backward and update passes and measure
+    // per-layer gradient norms and update ratios. Costs a few clock reads
+    // per sample.
+    bool detailed_metrics = false;
+
+    // Train under the network's current input normalization instead of
+    // recomputing it from the data, for continuing to train weights that
+    // were fitted to it
+    bool keep_normalization = false;
+};
+
+// Input normalization learned from the training data
+struct NormalizationParams
+{
+    double mean_bally = 0.0, std_bally = 1.0;
+    double mean_paddley = 0.0, std_paddley = 1.0;
+};
+
+// Mean and standard deviation of both inputs over a training set
+NormalizationParams compute_normalization(const TrainingView& training_data);
+
+// Feed forward network templated on the scalar type of its weights and
+// activations. Instantiated for double (PongNeuralNetwork) and float
+// (PongNeuralNetworkF).
+template <typename Scalar>
+class BasicPongNeuralNetwork {
+public:
+    using Workspace = BasicInferenceWorkspace<Scalar>;
+    using BatchInferenceWorkspaceType = BasicBatchInferenceWorkspace<Scalar>;
 
-class PongNeuralNetwork {
 private:
+    // The benchmark suite times the private propagation steps directly
+    friend class NetworkBenchmark;
+
+    // Converting constructors read the weights of other instantiations
+    template <typename Other>
+    friend class BasicPongNeuralNetwork;
+
     // Normalization parameters
     double mean_bally = 0.0, std_bally = 1.0;
     double mean_paddley = 0.0, std_paddley = 1.0;
 
     // Network architecture
     std::vector<int> layer_sizes;
-    std::vector<std::vector<std::vector<double>>> weights;
-    std::vector<std::vector<double>> biases;
-    std::vector<std::vector<double>> layer_outputs;
+
+    // Weights and biases of every layer packed into one aligned buffer.
+    // Layer i stores a row-major (layer_sizes[i+1] x layer_sizes[i]) weight
+    // matrix at weight_offsets[i] followed by its biases at bias_offsets[i].
+    AlignedVector<Scalar> parameters;
+    std::vector<size_t> weight_offsets;
+    std::vector<size_t> bias_offsets;
+    size_t parameter_count = 0;
+
+    // A network loaded from a model file reads its parameters straight out
+    // of the read-only mapping until training needs a private copy
+    std::shared_ptr<const MappedFile> mapped_file;
+    const Scalar* mapped_parameters = nullptr;
+
+    // Compute per-layer offsets for the current architecture
+    void layout_parameters();
+
+    // Lay out and allocate the parameter buffer
+    void allocate_parameters();
+
+    // Copy mapped parameters into the owned buffer before modifying them
+    void detach_parameters();
+
+    const Scalar* parameter_data() const { return mapped_parameters ? mapped_parameters : parameters.data(); }
+
+    // Bumped whenever training or the math mode changes what the network
+    // answers
+    unsigned long weights_version = 0;
+
+    // Optional precomputed moves (see enable_policy_table). The table is
+    // only consulted while it was built from the current weights_version.
+    std::shared_ptr<const PolicyTable> policy_table;
+    unsigned long policy_table_version = 0;
+    bool policy_table_enabled = false;
+    int policy_table_threads = 0;
+
+    // Evaluate the network over every table state and swap the new table in
+    void rebuild_policy_table();
+
+    // Table for the current weights, nullptr if there is none
+    const PolicyTable* current_policy_table() const;
+
+    // Batched prediction through the network itself, never the table
+    void infer_moves(const int* bally, const int* paddley, int* moves, int count, BatchInferenceWorkspaceType& workspace) const;
+
+    // Mutable access is only valid on owned parameters (see detach_parameters)
+    Scalar* mutable_layer_weights(size_t layer) { return parameters.data() + weight_offsets[layer]; }
+    Scalar* mutable_layer_biases(size_t layer) { return parameters.data() + bias_offsets[layer]; }
+    const Scalar* layer_weights(size_t layer) const { return parameter_data() + weight_offsets[layer]; }
+    const Scalar* layer_biases(size_t layer) const { return parameter_data() + bias_offsets[layer]; }
 
     // Random number generator for weight initialization
-    std::random_device rd;
     std::mt19937 gen;
     std::uniform_real_distribution<> dis;
 
-    // Activation function (tanh) and derivative
-    double activation_tanh(double x);
-    double tanh_derivative(double x);
+    // How tanh and the output softmax are evaluated (see fast-math.h)
+    MathMode math_mode = MathMode::Exact;
+
+    // Read only forward pass through caller owned buffers, returns the output
+    // logits. Softmax keeps their order, so deciding needs no exp calls.
+    const Scalar* infer(const GameState& state, Workspace& workspace) const;
+
+    // Loss and gradient magnitudes accumulated over an epoch
+    struct EpochStats
+    {
+        double total_loss = 0.0;
+        double max_gradient = 0.0;
+        double min_gradient = std::numeric_limits<double>::max();
+
+        // With detailed metrics: phase times, and per weight layer the sum
+        // over updates of the squared gradient norm (per-sample steps only,
+        // batches are measured after their reduction)
+        bool detailed = false;
+        double forward_seconds = 0.0;
+        double backward_seconds = 0.0;
+        double update_seconds = 0.0;
+        double* gradient_sq = nullptr;
+    };
 
-    // Softmax function for the output layer
-    std::vector<double> softmax(const std::vector<double>& input);
+    // Per-sample SGD step: one forward pass whose cached activations feed
+    // the backward pass and weight update, temporaries come from the arena
+    void train_step(const GameState& state, int target, Scalar learning_rate, ScratchArena& arena, EpochStats& stats);
 
-    // Forward propagation
-    std::vector<double> forward_propagate(const std::vector<double>& input);
+    // Row-major (batch x width) activations and deltas for every layer plus
+    // gradients laid out exactly like the parameter buffer
+    struct BatchWorkspace
+    {
+        std::vector<AlignedVector<Scalar>> activations;
+        std::vector<AlignedVector<Scalar>> deltas;
+        AlignedVector<Scalar> gradients;
+    };
 
-    // Backpropagation
-    void backpropagate(const std::vector<double>& input, const std::vector<double>& output_gradient, double learning_rate);
+    // Size a batch workspace for up to batch samples
+    void prepare_batch_workspace(BatchWorkspace& workspace, int batch) const;
+
+    // Forward and backward pass over a batch, adding its gradients into the workspace
+    void accumulate_batch_gradients(const TrainingView& training_data, const int* indices, int count, BatchWorkspace& workspace, EpochStats& stats) const;
 
     // Input normalization for game state
-    std::vector<double> normalize_input(const GameState& state);
-    void compute_normalization_params(const std::vector<GameState>& training_data);
+    void normalize_input(const GameState& state, Scalar* out) const;
+    void compute_normalization_params(const TrainingView& training_data);
+
+    // Network viewing parameters that live in a mapped model file
+    BasicPongNeuralNetwork(const std::vector<int>& arch, std::shared_ptr<const MappedFile> file, const Scalar* weights);
 
 public:
     // Constructor: define network architecture
-    PongNeuralNetwork(const std::vector<int>& arch);
+    BasicPongNeuralNetwork(const std::vector<int>& arch);
+
+    // Same, with a fixed seed for weight initialization and shuffling
+    BasicPongNeuralNetwork(const std::vector<int>& arch, unsigned seed);
+
+    // Deep copy. The parameters are one flat buffer, so this is a single
+    // allocation and copy (a network viewing mapped or external parameters
+    // shares them instead). The copy gets its own random seed.
+    BasicPongNeuralNetwork(const BasicPongNeuralNetwork& net);
+    BasicPongNeuralNetwork& operator=(const BasicPongNeuralNetwork& net);
+
+    // Moves take the buffer, the policy table and the random state along
+    BasicPongNeuralNetwork(BasicPongNeuralNetwork&& net) noexcept = default;
+    BasicPongNeuralNetwork& operator=(BasicPongNeuralNetwork&& net) noexcept = default;
+
+    // Convert a trained network to this scalar type
+    template <typename Other>
+    explicit BasicPongNeuralNetwork(const BasicPongNeuralNetwork<Other>& net);
+
+    // Read only access for tools that post-process a trained network
+    const std::vector<int>& get_layer_sizes() const { return layer_sizes; }
+    const Scalar* get_layer_weights(size_t layer) const { return layer_weights(layer); }
+    const Scalar* get_layer_biases(size_t layer) const { return layer_biases(layer); }
+    NormalizationParams get_normalization() const { return {mean_bally, std_bally, mean_paddley, std_paddley}; }
+    size_t parameter_bytes() const { return parameter_count * sizeof(Scalar); }
 
-    // Copy constructor for PongNeuralNetwork
-    PongNeuralNetwork(PongNeuralNetwork& net);
+    // Every weight and bias in the packed layout above, padding included
+    const Scalar* get_parameters() const { return parameter_data(); }
+    size_t get_parameter_count() const { return parameter_count; }
+
+    // Copy in get_parameter_count() values laid out like get_parameters()
+    void set_parameters(const Scalar* values);
+
+    // Read parameters straight from caller owned memory laid out like
+    // get_parameters(), which must outlive this network or the next call
+    // to set_parameters, view_parameters or train (train copies them first)
+    void view_parameters(const Scalar* values);
+
+    // Replace the input scaling train would compute, for networks that are
+    // never trained on a dataset
+    void set_normalization(const NormalizationParams& params);
+
+    // Size a workspace for this network so later predictions never allocate
+    void prepare_workspace(Workspace& workspace) const;
 
     // Predict optimal paddle movement based on state
-    int predict_move(GameState gamestate);
+    int predict_move(const GameState& gamestate, Workspace& workspace) const;
+
+    // Same as above using a per-thread workspace
+    int predict_move(const GameState& gamestate) const;
+
+    // Predict moves for count games given as structure of arrays state
+    void predict_moves(const int* bally, const int* paddley, int* moves, int count, BatchInferenceWorkspaceType& workspace) const;
+
+    // Answer predictions from a table of the network's move for every
+    // reachable state, built now on num_threads threads (<= 0 uses all
+    // cores) and rebuilt after every train call. States outside the table
+    // still go through the network.
+    void enable_policy_table(bool enabled, int num_threads = 0);
+
+    // Size of the current policy table, 0 when there is none
+    size_t policy_table_bytes() const;
+
+    // Exact libm activations (the default) or the vectorized approximations
+    // for inference and training. Changing it rebuilds the policy table.
+    void set_math_mode(MathMode mode);
+    MathMode get_math_mode() const { return math_mode; }
+
+    // Counts weight changes, a cached result is current while this is unchanged
+    unsigned long get_weights_version() const { return weights_version; }
+
+    // Write the architecture, normalization and weights to a binary model file
+    bool save(const std::string& filename) const;
+
+    // Map a model file written by save, returns nullptr on error
+    static std::unique_ptr<BasicPongNeuralNetwork> load(const std::string& filename);
 
     // Train method using simple gradient descent
-    void train(const std::vector<GameState>& training_data, const std::vector<int>& expected_moves, double learning_rate, int epochs);
+    void train(const std::vector<GameState>& training_data, const std::vector<int>& expected_moves, double learning_rate, int epochs,
+               const TrainOptions& options = TrainOptions());
+
+    // Same, reading samples in place through a view
+    void train(const TrainingView& training_data, double learning_rate, int epochs, const TrainOptions& options = TrainOptions());
 };
 
+using PongNeuralNetwork = BasicPongNeuralNetwork<double>;
+using PongNeuralNetworkF = BasicPongNeuralNetwork<float>;
+
+// Both scalar types are compiled once in network.cpp and model-file.cpp
+extern template class BasicPongNeuralNetwork<double>;
+extern template class BasicPongNeuralNetwork<float>;
+
 #endif
\ No newline at end of file
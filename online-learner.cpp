@@ -0,0 +1,165 @@
+#include "online-learner.h"
+#include "training-metrics.h"
+#include <algorithm>
+#include <chrono>
+
+OnlineLearner::OnlineLearner(const PongNeuralNetwork& initial, Labeler labeler, const Options& learner_options)
+    : options(learner_options), label(std::move(labeler)), trainer(new PongNeuralNetwork(initial))
+{
+    options.replay_capacity = std::max(1, options.replay_capacity);
+    options.update_samples = std::max(1, options.update_samples);
+    options.epochs_per_update = std::max(1, options.epochs_per_update);
+
+    replay_bally.reserve(options.replay_capacity);
+    replay_paddley.reserve(options.replay_capacity);
+    replay_moves.reserve(options.replay_capacity);
+
+    // Tables would be rebuilt on every publish, decisions go through the
+    // network. The input scaling stays the source network's, updates only
+    // change the weights.
+    trainer->enable_policy_table(false);
+    for (auto& network : networks)
+    {
+        network.reset(new PongNeuralNetwork(*trainer));
+    }
+
+    worker = std::thread(&OnlineLearner::run, this);
+}
+
+OnlineLearner::~OnlineLearner()
+{
+    stopping.store(true, std::memory_order_relaxed);
+    worker.join();
+}
+
+// Game thread ---------------------------------------------------------------
+
+void OnlineLearner::record(const GameState& state)
+{
+    ++recorded;
+    if (!incoming.push(state))
+    {
+        ++dropped;
+    }
+}
+
+// Announce the network before using it, then make sure it is still the
+// published one, otherwise the learner may already be writing it
+int OnlineLearner::enter_published()
+{
+    int index = published.load();
+    while (true)
+    {
+        reading.store(index);
+        int current = published.load();
+        if (current == index)
+        {
+            return index;
+        }
+        index = current;
+    }
+}
+
+int OnlineLearner::predict_move(const GameState& state)
+{
+    int index = enter_published();
+    int move = networks[index]->predict_move(state);
+    leave_published();
+    return move;
+}
+
+PongNeuralNetwork OnlineLearner::snapshot()
+{
+    int index = enter_published();
+    PongNeuralNetwork copy(*networks[index]);
+    leave_published();
+    return copy;
+}
+
+OnlineLearner::Stats OnlineLearner::get_stats() const
+{
+    Stats stats;
+    stats.recorded = recorded;
+    stats.dropped = dropped;
+    stats.updates = updates.load(std::memory_order_relaxed);
+    stats.last_update_seconds = last_update_seconds.load(std::memory_order_relaxed);
+    return stats;
+}
+
+// Learner thread ------------------------------------------------------------
+
+void OnlineLearner::run()
+{
+    int idle = 0;
+    int fresh = 0;
+    GameState state;
+    while (!stopping.load(std::memory_order_relaxed))
+    {
+        if (!incoming.pop(state))
+        {
+            if (++idle < IDLE_SPINS)
+            {
+                std::this_thread::yield();
+            }
+            else
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds(IDLE_SLEEP_US));
+            }
+            continue;
+        }
+        idle = 0;
+
+        int move = label(state);
+        if (replay_bally.size() < static_cast<size_t>(options.replay_capacity))
+        {
+            replay_bally.push_back(state.bally);
+            replay_paddley.push_back(state.paddley);
+            replay_moves.push_back(move);
+        }
+        else
+        {
+            replay_bally[replay_next] = state.bally;
+            replay_paddley[replay_next] = state.paddley;
+            replay_moves[replay_next] = move;
+            replay_next = (replay_next + 1) % replay_bally.size();
+        }
+
+        if (++fresh >= options.update_samples)
+        {
+            fresh = 0;
+            update();
+        }
+    }
+}
+
+void OnlineLearner::update()
+{
+    auto start = std::chrono::steady_clock::now();
+
+    TrainingView view;
+    view.bally = replay_bally.data();
+    view.paddley = replay_paddley.data();
+    view.moves = replay_moves.data();
+    view.size = replay_bally.size();
+
+    SilentTrainingSink sink;
+    TrainOptions train_options;
+    train_options.batch_size = options.batch_size;
+    train_options.sink = &sink;
+    train_options.keep_normalization = true;
+    trainer->train(view, options.learning_rate, options.epochs_per_update, train_options);
+
+    // The reader may still be inside the spare network if it picked it up
+    // just before the previous swap, it leaves within one prediction
+    int spare = 1 - published.load();
+    while (reading.load() == spare)
+    {
+        std::this_thread::yield();
+    }
+
+    networks[spare]->set_parameters(trainer->get_parameters());
+    published.store(spare);
+
+    updates.fetch_add(1, std::memory_order_relaxed);
+    last_update_seconds.store(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(), std::memory_order_relaxed);
+}
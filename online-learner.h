@@ -0,0 +1,127 @@
+#ifndef PONG_ONLINE_LEARNER_H
+#define PONG_ONLINE_LEARNER_H
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "config.h"
+#include "network.h"
+#include "spsc-ring.h"
+
+// Keeps training a copy of the network on states seen in live play while
+// the game goes on deciding with the last published weights.
+//
+// The game thread records every state through a bounded SPSC ring (a full
+// ring drops the state, it never waits). The learner thread labels the
+// states, keeps the newest replay_capacity of them, and after every
+// update_samples new ones trains its private network over the replay
+// buffer and publishes the result. The input normalization is the one the
+// initial network came with and never changes, only weights are published.
+//
+// Publication is an RCU style double buffer. Readers use whichever of two
+// networks the published index names. The learner writes the other one,
+// then swaps the index. Before it overwrites a network it waits until the
+// reader is not inside it, so a reader never sees torn weights and never
+// waits itself. The reader announces the network it uses in a hazard slot
+// and re-checks the index, which is why all of that protocol is seq_cst.
+//
+// record belongs to the game thread. predict_move may be called from one
+// thread at a time (the game thread, or an agent thread instead of it).
+class OnlineLearner
+{
+public:
+    // Move a recorded state should have led to
+    using Labeler = std::function<int(const GameState&)>;
+
+    struct Options
+    {
+        // Newest labelled states kept for training
+        int replay_capacity = 4096;
+
+        // New states between updates, and epochs over the replay buffer per update
+        int update_samples = 512;
+        int epochs_per_update = 1;
+
+        double learning_rate = 0.0001;
+        int batch_size = 1;
+    };
+
+    struct Stats
+    {
+        long recorded = 0;  // states the game offered
+        long dropped = 0;   // ring full, state not kept
+        long updates = 0;   // weights published
+        double last_update_seconds = 0.0;
+    };
+
+private:
+    static const std::size_t RING_SIZE = 1024;
+
+    // Learner thread sleeps this long once the ring stayed empty for a while
+    static const int IDLE_SPINS = 64;
+    static const int IDLE_SLEEP_US = 200;
+
+    Options options;
+    Labeler label;
+
+    SpscRing<GameState, RING_SIZE> incoming;
+
+    // Learner thread only: replay buffer as training columns, filled
+    // round robin once full, and the network it trains
+    std::vector<int> replay_bally;
+    std::vector<int> replay_paddley;
+    std::vector<int> replay_moves;
+    size_t replay_next = 0;
+    std::unique_ptr<PongNeuralNetwork> trainer;
+
+    // Double buffer: published names the network readers use, reading is
+    // the one the reader is inside (-1 when none)
+    std::array<std::unique_ptr<PongNeuralNetwork>, 2> networks;
+    std::atomic<int> published{0};
+    std::atomic<int> reading{-1};
+
+    std::atomic<long> updates{0};
+    std::atomic<double> last_update_seconds{0.0};
+    std::atomic<bool> stopping{false};
+
+    // Game thread only
+    long recorded = 0;
+    long dropped = 0;
+
+    std::thread worker;
+
+    void run();
+
+    // Train on the replay buffer and swap the result in
+    void update();
+
+    // Hazard protocol around the published network (see the class comment)
+    int enter_published();
+    void leave_published() { reading.store(-1); }
+
+public:
+    OnlineLearner(const PongNeuralNetwork& initial, Labeler labeler, const Options& learner_options);
+    ~OnlineLearner();
+
+    OnlineLearner(const OnlineLearner&) = delete;
+    OnlineLearner& operator=(const OnlineLearner&) = delete;
+
+    // Offer a state seen in play, never blocks
+    void record(const GameState& state);
+
+    // Decide with the newest published weights, never blocks
+    int predict_move(const GameState& state);
+
+    // Copy of the newest published network, same threading rule as predict_move
+    PongNeuralNetwork snapshot();
+
+    // Times new weights were published
+    long get_update_count() const { return updates.load(std::memory_order_relaxed); }
+
+    Stats get_stats() const;
+};
+
+#endif
@@ -0,0 +1,20 @@
+#include "policy-table.h"
+#include "thread-pool.h"
+
+void PolicyTable::build(const std::function<void(int, int*)>& row, int num_threads)
+{
+    words.assign(static_cast<size_t>(BALL_POSITIONS) * ROW_WORDS, 0);
+
+    ThreadPool pool(num_threads);
+    pool.parallel_for(BALL_POSITIONS, [&](int bally) {
+        int moves[PADDLE_POSITIONS];
+        row(bally, moves);
+
+        // Pack the row, only this task writes these words
+        uint64_t* packed = words.data() + static_cast<size_t>(bally) * ROW_WORDS;
+        for (int paddley = 0; paddley < PADDLE_POSITIONS; ++paddley)
+        {
+            packed[paddley / MOVES_PER_WORD] |= static_cast<uint64_t>(moves[paddley] & 3) << (paddley % MOVES_PER_WORD * 2);
+        }
+    });
+}
@@ -0,0 +1,51 @@
+#ifndef PONG_POLICY_TABLE_H
+#define PONG_POLICY_TABLE_H
+
+#include <cstdint>
+#include <functional>
+#include "config.h"
+#include "dense-kernels.h"
+
+// Precomputed move for every state the game can produce: bally in
+// [0, SCREEN_HEIGHT] and paddley in [0, SCREEN_HEIGHT - PADDLE_HEIGHT].
+//
+// Moves take 2 bits, 32 to a 64-bit word. Each bally row is padded to a
+// whole number of words (16 words, one 128 byte pair of cache lines), so
+// rows can be filled by different threads without sharing a word. The
+// whole table is about 75 KiB whatever the size of the network behind it.
+class PolicyTable
+{
+public:
+    static const int BALL_POSITIONS = SCREEN_HEIGHT + 1;
+    static const int PADDLE_POSITIONS = SCREEN_HEIGHT - PADDLE_HEIGHT + 1;
+
+private:
+    static const int MOVES_PER_WORD = 32;
+    static const int ROW_WORDS = (PADDLE_POSITIONS + MOVES_PER_WORD - 1) / MOVES_PER_WORD;
+
+    AlignedVector<uint64_t> words;
+
+public:
+    // Fill the table, row(bally, moves) writes the move for every paddley
+    // in [0, PADDLE_POSITIONS). Rows are evaluated in parallel on
+    // num_threads threads (<= 0 uses all cores).
+    void build(const std::function<void(int, int*)>& row, int num_threads);
+
+    bool empty() const { return words.empty(); }
+    size_t bytes() const { return words.size() * sizeof(uint64_t); }
+
+    // Move for a state, -1 if the state is outside the table
+    int lookup(const GameState& state) const
+    {
+        if (static_cast<unsigned>(state.bally) >= static_cast<unsigned>(BALL_POSITIONS) ||
+            static_cast<unsigned>(state.paddley) >= static_cast<unsigned>(PADDLE_POSITIONS))
+        {
+            return -1;
+        }
+
+        uint64_t word = words[static_cast<size_t>(state.bally) * ROW_WORDS + state.paddley / MOVES_PER_WORD];
+        return static_cast<int>((word >> (state.paddley % MOVES_PER_WORD * 2)) & 3);
+    }
+};
+
+#endif
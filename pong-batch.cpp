@@ -0,0 +1,130 @@
+#include "pong-batch.h"
+#include <algorithm>
+#include <random>
+
+// Ball reset position
+const int RESET_X = SCREEN_WIDTH / 2 - BALL_SIZE / 2;
+const int RESET_Y = SCREEN_HEIGHT / 2 - BALL_SIZE / 2;
+
+// Start every game from the PongSimulation initial state
+PongBatchSimulation::PongBatchSimulation(int games)
+    : count(games),
+    ball_x(games, RESET_X),
+    ball_y(games, RESET_Y),
+    speed_x(games, BALL_SPEED),
+    speed_y(games, BALL_SPEED),
+    paddle_y(games, SCREEN_HEIGHT / 2 - PADDLE_HEIGHT / 2),
+    score(games, 0),
+    hits(games, 0),
+    misses(games, 0),
+    best_score(games, 0),
+    ticks(0)
+{
+}
+
+// Scatter the starting paddle heights
+PongBatchSimulation::PongBatchSimulation(int games, unsigned seed) : PongBatchSimulation(games)
+{
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<int> dis(0, SCREEN_HEIGHT - PADDLE_HEIGHT);
+    for (int& paddle : paddle_y)
+    {
+        paddle = dis(gen);
+    }
+}
+
+// Same rules as PongSimulation::step with every branch turned into a
+// 0/-1 mask, so the loop body is straight line code the compiler vectorizes
+void PongBatchSimulation::step(const int* actions)
+{
+    int* __restrict bx = ball_x.data();
+    int* __restrict by = ball_y.data();
+    int* __restrict sx = speed_x.data();
+    int* __restrict sy = speed_y.data();
+    int* __restrict py = paddle_y.data();
+    int* __restrict sc = score.data();
+    int* __restrict hit_count = hits.data();
+    int* __restrict miss_count = misses.data();
+    int* __restrict best = best_score.data();
+    const int* __restrict act = actions;
+    const int games = count;
+
+#pragma omp simd
+    for (int i = 0; i < games; ++i)
+    {
+        // Paddle move, clamped to the screen
+        int up = -(act[i] == MOVE_UP);
+        int down = -(act[i] == MOVE_DOWN);
+        int paddle = py[i] - (up & PADDLE_SPEED) + (down & PADDLE_SPEED);
+        paddle = paddle < 0 ? 0 : paddle;
+        paddle = paddle > SCREEN_HEIGHT - PADDLE_HEIGHT ? SCREEN_HEIGHT - PADDLE_HEIGHT : paddle;
+
+        // Move the ball
+        int x = bx[i] + sx[i];
+        int y = by[i] + sy[i];
+        int vx = sx[i];
+        int vy = sy[i];
+        int s = sc[i];
+
+        // Top bottom walls
+        int wall = -((y <= BALL_SIZE) | (y >= SCREEN_HEIGHT - BALL_SIZE));
+        vy = (vy ^ wall) - wall;
+
+        // Right wall
+        int right = -(x >= SCREEN_WIDTH - BALL_SIZE);
+        vx = (vx ^ right) - right;
+
+        // Left wall resets the ball and the score
+        int left = -(x <= BALL_SIZE);
+        x = (x & ~left) | (RESET_X & left);
+        y = (y & ~left) | (RESET_Y & left);
+        vx = (vx & ~left) | (BALL_SPEED & left);
+        vy = (vy & ~left) | (BALL_SPEED & left);
+        s &= ~left;
+
+        // Paddle
+        int hit = -((PADDLE_X < x + BALL_SIZE) & (x < PADDLE_X + PADDLE_WIDTH) &
+                    (paddle < y + BALL_SIZE) & (y < paddle + PADDLE_HEIGHT));
+        vx = (vx ^ hit) - hit;
+        x += vx & hit;
+        y += vy & hit;
+        s -= hit;
+
+        bx[i] = x;
+        by[i] = y;
+        sx[i] = vx;
+        sy[i] = vy;
+        py[i] = paddle;
+        sc[i] = s;
+        hit_count[i] -= hit;
+        miss_count[i] -= left;
+        best[i] = best[i] > s ? best[i] : s;
+    }
+
+    ++ticks;
+}
+
+long PongBatchSimulation::total_hits() const
+{
+    long total = 0;
+    for (int h : hits)
+    {
+        total += h;
+    }
+    return total;
+}
+
+long PongBatchSimulation::total_misses() const
+{
+    long total = 0;
+    for (int m : misses)
+    {
+        total += m;
+    }
+    return total;
+}
+
+int PongBatchSimulation::max_best_score() const
+{
+    return count > 0 ? *std::max_element(best_score.begin(), best_score.end()) : 0;
+}
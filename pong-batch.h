@@ -0,0 +1,86 @@
+#ifndef PONG_BATCH_H
+#define PONG_BATCH_H
+
+#include <chrono>
+#include "config.h"
+#include "dense-kernels.h"
+#include "pong-sim.h"
+
+// Many independent games stored as structure of arrays. Every field is a
+// contiguous int array so one step advances all games in SIMD lanes, with
+// the wall, paddle and reset rules of PongSimulation applied as masks.
+class PongBatchSimulation
+{
+private:
+    int count;
+
+    // Per game state
+    AlignedVector<int> ball_x;
+    AlignedVector<int> ball_y;
+    AlignedVector<int> speed_x;
+    AlignedVector<int> speed_y;
+    AlignedVector<int> paddle_y;
+    AlignedVector<int> score;
+
+    // Per game totals
+    AlignedVector<int> hits;
+    AlignedVector<int> misses;
+    AlignedVector<int> best_score;
+
+    long ticks;
+
+public:
+    explicit PongBatchSimulation(int games);
+
+    // Same, but every game starts with its paddle at a random height so
+    // the games don't all play out identically
+    PongBatchSimulation(int games, unsigned seed);
+
+    // Advance every game one frame, actions[i] drives game i
+    void step(const int* actions);
+
+    int size() const { return count; }
+    long get_ticks() const { return ticks; }
+
+    // Agent inputs for every game, laid out for batched inference
+    const int* bally() const { return ball_y.data(); }
+    const int* paddley() const { return paddle_y.data(); }
+
+    const int* ballx() const { return ball_x.data(); }
+    const int* speedx() const { return speed_x.data(); }
+    const int* speedy() const { return speed_y.data(); }
+    const int* scores() const { return score.data(); }
+
+    // Totals across all games
+    long total_hits() const;
+    long total_misses() const;
+    int max_best_score() const;
+};
+
+// Tick every game as fast as possible. policy(bally, paddley, moves, n)
+// fills one move per game from the structure of arrays state.
+template <typename Policy>
+SimReport run_headless_batch(PongBatchSimulation& sim, Policy&& policy, long ticks)
+{
+    AlignedVector<int> moves(sim.size(), MOVE_NONE);
+    long start_ticks = sim.get_ticks();
+    long start_hits = sim.total_hits();
+    long start_misses = sim.total_misses();
+
+    auto start = std::chrono::steady_clock::now();
+    for (long t = 0; t < ticks; ++t)
+    {
+        policy(sim.bally(), sim.paddley(), moves.data(), sim.size());
+        sim.step(moves.data());
+    }
+
+    SimReport report;
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    report.ticks = (sim.get_ticks() - start_ticks) * sim.size();
+    report.hits = sim.total_hits() - start_hits;
+    report.rallies = sim.total_misses() - start_misses;
+    report.best_score = sim.max_best_score();
+    return report;
+}
+
+#endif
@@ -0,0 +1,108 @@
+#include "pong-sim.h"
+#include <algorithm>
+
+bool has_intersection(const Rect& a, const Rect& b)
+{
+    if (a.w <= 0 || a.h <= 0 || b.w <= 0 || b.h <= 0)
+    {
+        return false;
+    }
+
+    return a.x < b.x + b.w && b.x < a.x + a.w &&
+           a.y < b.y + b.h && b.y < a.y + a.h;
+}
+
+// Init the game objects
+PongSimulation::PongSimulation() : score(0), ticks(0), hits(0), misses(0), best_score(0)
+{
+    // Init paddle
+    paddle.x = PADDLE_X;
+    paddle.y = SCREEN_HEIGHT / 2 - PADDLE_HEIGHT / 2;
+    paddle.w = PADDLE_WIDTH;
+    paddle.h = PADDLE_HEIGHT;
+
+    // Init ball
+    ball.h = BALL_SIZE;
+    ball.w = BALL_SIZE;
+
+    // Setup ball position and speed
+    reset_ball();
+}
+
+// Reset the ball
+void PongSimulation::reset_ball()
+{
+    ball.x = SCREEN_WIDTH / 2 - BALL_SIZE / 2;
+    ball.y = SCREEN_HEIGHT / 2 - BALL_SIZE / 2;
+
+    ball_speedx = BALL_SPEED;
+    ball_speedy = BALL_SPEED;
+
+    // Reset score
+    score = 0;
+}
+
+// Advance one frame
+void PongSimulation::step(int action)
+{
+    if (action == MOVE_UP)
+    {
+        paddle.y = std::max(0, paddle.y - PADDLE_SPEED);
+    }
+
+    if (action == MOVE_DOWN)
+    {
+        paddle.y = std::min(SCREEN_HEIGHT - PADDLE_HEIGHT, paddle.y + PADDLE_SPEED);
+    }
+
+    // Move the ball
+    ball.x += ball_speedx;
+    ball.y += ball_speedy;
+
+    // Check for collisions
+    checkcollision();
+
+    ++ticks;
+}
+
+// Check for colisions
+void PongSimulation::checkcollision()
+{
+    // Top bottom walls
+    if(ball.y <= 0 + ball.w || ball.y >= SCREEN_HEIGHT - ball.w)
+    {
+        ball_speedy = -ball_speedy;
+    }
+
+    // Right wall
+    if(ball.x >= SCREEN_WIDTH - ball.w)
+    {
+        ball_speedx = -ball_speedx;
+    }
+
+    // left wall
+    if(ball.x <= 0 + ball.w)
+    {
+        ++misses;
+        reset_ball();
+    }
+
+    // Paddle
+    if(has_intersection(paddle, ball))
+    {
+        ball_speedx = -ball_speedx;
+        ball.x += ball_speedx;
+        ball.y += ball_speedy;
+        score++;
+        ++hits;
+        best_score = std::max(best_score, score);
+    }
+}
+
+void print_sim_report(const SimReport& report, std::ostream& out)
+{
+    out << "Headless run: " << report.ticks << " ticks in " << report.seconds << "s ("
+        << static_cast<long>(report.ticks_per_second()) << " ticks/s)\n"
+        << "  hits: " << report.hits << " - rallies: " << report.rallies
+        << " - hits/rally: " << report.hits_per_rally() << " - best score: " << report.best_score << "\n";
+}
@@ -0,0 +1,110 @@
+#ifndef PONG_SIM_H
+#define PONG_SIM_H
+
+#include <chrono>
+#include <ostream>
+#include "config.h"
+
+// Plain rectangle so the game rules don't depend on SDL
+struct Rect
+{
+    int x;
+    int y;
+    int w;
+    int h;
+};
+
+// Same semantics as SDL_HasIntersection (empty rects never intersect)
+bool has_intersection(const Rect& a, const Rect& b);
+
+// Paddle actions, matching the network's output indices
+enum PaddleMove
+{
+    MOVE_DOWN = 0,
+    MOVE_UP = 1,
+    MOVE_NONE = 2
+};
+
+// Pong rules without any rendering, advanced one frame per step
+class PongSimulation
+{
+private:
+    // Game objects
+    Rect paddle;
+    Rect ball;
+
+    // Game State
+    int score;
+    int ball_speedx;
+    int ball_speedy;
+
+    // Running totals for reports
+    long ticks;
+    long hits;
+    long misses;
+    int best_score;
+
+    void reset_ball();
+    void checkcollision();
+
+public:
+    PongSimulation();
+
+    // Apply a paddle move, then advance the ball and resolve collisions
+    void step(int action);
+
+    // Agent view of the current frame
+    GameState state() const { return {ball.y, paddle.y}; }
+
+    const Rect& get_paddle() const { return paddle; }
+    const Rect& get_ball() const { return ball; }
+    int get_ball_speedx() const { return ball_speedx; }
+    int get_ball_speedy() const { return ball_speedy; }
+    int get_score() const { return score; }
+
+    long get_ticks() const { return ticks; }
+    long get_hits() const { return hits; }
+    long get_misses() const { return misses; }
+    int get_best_score() const { return best_score; }
+};
+
+// Outcome of a headless run
+struct SimReport
+{
+    long ticks = 0;
+    long hits = 0;
+    long rallies = 0;
+    int best_score = 0;
+    double seconds = 0.0;
+
+    double ticks_per_second() const { return seconds > 0.0 ? ticks / seconds : 0.0; }
+    double hits_per_rally() const { return rallies > 0 ? static_cast<double>(hits) / rallies : static_cast<double>(hits); }
+};
+
+// Tick the simulation as fast as possible, asking policy(GameState) for every move
+template <typename Policy>
+SimReport run_headless(PongSimulation& sim, Policy&& policy, long ticks)
+{
+    long start_ticks = sim.get_ticks();
+    long start_hits = sim.get_hits();
+    long start_misses = sim.get_misses();
+
+    auto start = std::chrono::steady_clock::now();
+    for (long t = 0; t < ticks; ++t)
+    {
+        sim.step(policy(sim.state()));
+    }
+
+    SimReport report;
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    report.ticks = sim.get_ticks() - start_ticks;
+    report.hits = sim.get_hits() - start_hits;
+    report.rallies = sim.get_misses() - start_misses;
+    report.best_score = sim.get_best_score();
+    return report;
+}
+
+// Human readable summary of a headless run
+void print_sim_report(const SimReport& report, std::ostream& out);
+
+#endif
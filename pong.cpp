@@ -1,29 +1,20 @@
 #include "network.h"
 #include "pong.h"
 #include "train-data.h"
+#include "async-agent.h"
+#include "online-learner.h"
+#include <cmath>
+#include <cstdio>
 
 // Init pong class
-PongGame::PongGame(PongNeuralNetwork* net): window(nullptr), renderer(nullptr), score(0), running(true), network(net)
+PongGame::PongGame(const PongNeuralNetwork* net): window(nullptr), renderer(nullptr), running(true), network(net)
 {
+    previous_paddle = sim.get_paddle();
+    previous_ball = sim.get_ball();
+
     // Generate random seed
     std::srand(std::time(nullptr));
 
-    // Init paddle
-    paddle.x = 25;
-    paddle.y = SCREEN_HEIGHT / 2 - PADDLE_HEIGHT / 2;
-    paddle.w = PADDLE_WIDTH;
-    paddle.h = PADDLE_HEIGHT;
-
-    // Init ball
-    ball.x = SCREEN_WIDTH / 2 - BALL_SIZE / 2;
-    ball.y = SCREEN_HEIGHT / 2 - BALL_SIZE / 2;
-    ball.h = BALL_SIZE;
-    ball.w = BALL_SIZE;
-
-
-    // Setup ball speed
-    reset_ball();
-
     // Start SDL
     init_SDL();
 }
@@ -31,6 +22,22 @@ PongGame::PongGame(PongNeuralNetwork* net): window(nullptr), renderer(nullptr),
 // Delete pong object
 PongGame::~PongGame()
 {
+    // Stop the agent thread before anything it uses goes away
+    agent.reset();
+    learner.reset();
+    clearoverlay();
+    if (score_texture)
+    {
+        SDL_DestroyTexture(score_texture);
+    }
+    if (overlay_font)
+    {
+        TTF_CloseFont(overlay_font);
+    }
+    if (font)
+    {
+        TTF_CloseFont(font);
+    }
     if(renderer)
     {
         SDL_DestroyRenderer(renderer);
@@ -39,23 +46,10 @@ PongGame::~PongGame()
     {
         SDL_DestroyWindow(window);
     }
+    TTF_Quit();
     SDL_Quit();
 }
 
-// Reset the ball
-void PongGame::reset_ball()
-{
-    ball.x = SCREEN_WIDTH / 2 - BALL_SIZE / 2;
-    ball.y = SCREEN_HEIGHT / 2 - BALL_SIZE / 2;
-
-    // Randomize ball direction
-    ball_speedx = BALL_SPEED;
-    ball_speedy = BALL_SPEED;
-
-    // Reset score
-    score = 0;
-}
-
 // Init the SDL
 void PongGame::init_SDL()
 {
@@ -76,6 +70,13 @@ void PongGame::init_SDL()
         exit(1);
     }
 
+    // Smaller face for the profiler overlay, which is optional
+    overlay_font = TTF_OpenFont("/usr/share/fonts/truetype/dejavu/DejaVuSansMono.ttf", 13);
+    if (!overlay_font)
+    {
+        std::cerr << "Profiler overlay disabled, failed to load font:\n" << TTF_GetError() << std::endl;
+    }
+
     // Make window
     window = SDL_CreateWindow("Pong Game", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, SCREEN_WIDTH, SCREEN_HEIGHT, SDL_WINDOW_SHOWN);
     if(!window)
@@ -85,12 +86,24 @@ void PongGame::init_SDL()
     }
 
     // Render window
-    renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+    renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
     if(!renderer)
     {
         std::cerr << "Error making the renderer!:\n" << SDL_GetError() << std::endl;
         exit(1);
     }
+
+    // Drivers may ignore the vsync request, then frames are paced by sleeping
+    SDL_RendererInfo info;
+    vsync = SDL_GetRendererInfo(renderer, &info) == 0 && (info.flags & SDL_RENDERER_PRESENTVSYNC);
+
+    SDL_DisplayMode mode;
+    int refresh_rate = 60;
+    if (SDL_GetCurrentDisplayMode(SDL_GetWindowDisplayIndex(window), &mode) == 0 && mode.refresh_rate > 0)
+    {
+        refresh_rate = mode.refresh_rate;
+    }
+    frame_period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::nanoseconds(1000000000 / refresh_rate));
 }
 
 // Event Handler
@@ -103,25 +116,33 @@ void PongGame::handle_events()
         {
             running = false;
         }
+        else if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_F3 && overlay_font)
+        {
+            // Showing the overlay starts timing if it was not already on
+            show_overlay = !show_overlay;
+            if (show_overlay && !profiler.is_enabled())
+            {
+                profiler.set_enabled(true);
+            }
+            overlay_age = OVERLAY_REFRESH_FRAMES;
+        }
     }
 }
 
 // Update
 void PongGame::update_state(bool useai)
 {
-    // Move the ball
-    ball.x += ball_speedx;
-    ball.y += ball_speedy;
-
-    // Check for collisions
-    checkcollision();
-
-    GameState stateinput({ball.y, paddle.y});
-
-    int move = 2;
-    if (useai)
+    int move = MOVE_NONE;
+    if (useai && agent)
     {
-        move = network->predict_move(stateinput);
+        // Hand over this tick's state and act on the newest decision so far
+        agent->publish(sim.get_ticks(), sim.state());
+        move = agent->latest_move(sim.get_ticks(), MOVE_NONE);
+    }
+    else if (useai)
+    {
+        FrameProfiler::Scope timer(profiler, FramePhase::Inference);
+        move = decide(sim.state());
     }
     else
     {
@@ -130,126 +151,284 @@ void PongGame::update_state(bool useai)
 
         // Check if the up arrow key is pressed
         if (currentKeyStates[SDL_SCANCODE_UP]) {
-            move = 1;
+            move = MOVE_UP;
         }
 
         // Check if the down arrow key is pressed
         if (currentKeyStates[SDL_SCANCODE_DOWN]) {
-            move = 0;
+            move = MOVE_DOWN;
         }
     }
-    
-    if (move == 1)
-    {
-        paddle.y = std::max(0, paddle.y - PADDLE_SPEED);
-    }
 
-    if (move == 0)
+    // The learner sees every state played, whoever is moving the paddle
+    if (learner)
     {
-        paddle.y = std::min(SCREEN_HEIGHT - PADDLE_HEIGHT, paddle.y + PADDLE_SPEED);
+        learner->record(sim.state());
     }
+
+    // Move the paddle, then the ball
+    FrameProfiler::Scope timer(profiler, FramePhase::Physics);
+    sim.step(move);
 }
 
-// Check for colisions
-void PongGame::checkcollision()
+// Draw the state alpha of the way from the previous step to the current one
+void PongGame::render(double alpha)
 {
-    // Top bottom walls
-    if(ball.y <= 0 + ball.w || ball.y >= SCREEN_HEIGHT - ball.w)
     {
-        ball_speedy = -ball_speedy;
+        FrameProfiler::Scope timer(profiler, FramePhase::Render);
+        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+        SDL_RenderClear(renderer);
+
+        //set fill color
+        SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
+
+        // Render paddle and ball
+        const Rect& paddle = sim.get_paddle();
+        const Rect& ball = sim.get_ball();
+        auto blend = [](int from, int to, double t) { return static_cast<int>(std::lround(from + (to - from) * t)); };
+
+        // A ball reset teleports to the centre, don't draw it sweeping across
+        double ball_alpha = std::abs(ball.x - previous_ball.x) > 2 * BALL_SPEED ? 1.0 : alpha;
+        SDL_Rect paddlerect = {paddle.x, blend(previous_paddle.y, paddle.y, alpha), paddle.w, paddle.h};
+        SDL_Rect ballrect = {blend(previous_ball.x, ball.x, ball_alpha), blend(previous_ball.y, ball.y, ball_alpha), ball.w, ball.h};
+        SDL_RenderFillRect(renderer, &paddlerect);
+        SDL_RenderFillRect(renderer, &ballrect);
     }
 
-    // Right wall
-    if(ball.x >= SCREEN_WIDTH - ball.w)
+    // Render score and the profiler overlay
     {
-        ball_speedx = -ball_speedx;
+        FrameProfiler::Scope timer(profiler, FramePhase::Text);
+        renderscore();
+        if (show_overlay)
+        {
+            renderoverlay();
+        }
     }
 
-    // left wall
-    if(ball.x <= 0 + ball.w)
+    // Update screen
+    FrameProfiler::Scope timer(profiler, FramePhase::Present);
+    SDL_RenderPresent(renderer);
+}
+
+void PongGame::renderscore()
+{
+    // Rasterize and upload only when the score changed, a failure is
+    // reported once and retried on the next change
+    if (sim.get_score() != rendered_score)
     {
-        reset_ball();
+        rendered_score = sim.get_score();
+        if (score_texture)
+        {
+            SDL_DestroyTexture(score_texture);
+            score_texture = nullptr;
+        }
+
+        // Convert score to string
+        std::string scoretext = "Score: " + std::to_string(sim.get_score());
+
+        // Create score surface
+        SDL_Color textcolor = {255, 255, 255, 255}; // White
+        SDL_Surface* textsurface = TTF_RenderText_Solid(font, scoretext.c_str(), textcolor);
+        if(!textsurface)
+        {
+            std::cerr << "Unable to render text surface!\n" << TTF_GetError() << std::endl;
+            return;
+        }
+
+        // Create texture from surface, the surface is not needed after this
+        score_texture = SDL_CreateTextureFromSurface(renderer, textsurface);
+        score_width = textsurface->w;
+        score_height = textsurface->h;
+        SDL_FreeSurface(textsurface);
+        if(!score_texture)
+        {
+            std::cerr << "Unable to render text texture!\n" << SDL_GetError() << std::endl;
+            return;
+        }
     }
 
-    // Paddle
-    if(SDL_HasIntersection(&paddle, &ball))
+    if (!score_texture)
     {
-        ball_speedx = -ball_speedx;
-        ball.x += ball_speedx;
-        ball.y += ball_speedy;
-        score++;
+        return;
     }
-}
 
-void PongGame::render()
-{
-    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
-    SDL_RenderClear(renderer);
-
-    //set fill color
-    SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
+    SDL_Rect renderquad = {SCREEN_WIDTH - score_width - 20, 20, score_width, score_height};
 
-    // Render paddle and ball
-    SDL_RenderFillRect(renderer, &paddle);
-    SDL_RenderFillRect(renderer, &ball);
+    // Render text
+    SDL_RenderCopy(renderer, score_texture, NULL, &renderquad);
+}
 
-    // Render score
-    renderscore();
+void PongGame::set_async_agent(bool enabled)
+{
+    if (!enabled)
+    {
+        agent.reset();
+        return;
+    }
+    if (agent)
+    {
+        return;
+    }
 
-    // Update screen
-    SDL_RenderPresent(renderer);
+    // Inference is timed on the agent thread, so it feeds the histogram only
+    agent.reset(new AsyncAgent([this](const GameState& state) {
+        auto start = std::chrono::steady_clock::now();
+        int move = decide(state);
+        profiler.record_concurrent(FramePhase::Inference, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+        return move;
+    }));
 }
 
-void PongGame::renderscore()
+int PongGame::decide(const GameState& state)
 {
-    // Convert score to string
-    std::string scoretext = "Score: " + std::to_string(score);
+    return learner ? learner->predict_move(state) : network->predict_move(state);
+}
 
-    // Create score surface
-    SDL_Color textcolor = {255, 255, 255, 255}; // White
-    SDL_Surface* textsurface = TTF_RenderText_Solid(font, scoretext.c_str(), textcolor);
-    if(!textsurface)
+void PongGame::set_online_learning(bool enabled)
+{
+    if (enabled == static_cast<bool>(learner))
     {
-        std::cerr << "Unable to render text surface!\n" << TTF_GetError() << std::endl;
         return;
     }
 
-    // Create texture from surface
-    SDL_Texture* texttexture = SDL_CreateTextureFromSurface(renderer, textsurface);
-    if(!texttexture)
+    // The agent thread reads the learner, so it is stopped while it changes
+    bool restart_agent = static_cast<bool>(agent);
+    agent.reset();
+
+    if (enabled)
     {
-        std::cerr << "Unable to render text texture!\n" << SDL_GetError() << std::endl;
-        return;
+        PongStateGenerator teacher;
+        learner.reset(new OnlineLearner(*network, [teacher](const GameState& state) mutable {
+            return teacher.calculate_movement(state);
+        }, OnlineLearner::Options()));
+    }
+    else
+    {
+        learner.reset();
     }
 
-    int textwidth = textsurface->w;
-    int textheight = textsurface->h;
+    set_async_agent(restart_agent);
+}
 
-    SDL_Rect renderquad = {SCREEN_WIDTH - textwidth - 20, 20, textwidth, textheight};
+// Profiler overlay, one texture per line in the top left corner
+void PongGame::renderoverlay()
+{
+    if (++overlay_age >= OVERLAY_REFRESH_FRAMES)
+    {
+        overlay_age = 0;
+        clearoverlay();
 
-    // Render text
-    SDL_RenderCopy(renderer, texttexture, NULL, &renderquad);
+        std::vector<std::string> lines = profiler.summary_lines();
+        if (agent)
+        {
+            AsyncAgent::Stats stats = agent->get_stats();
+            char line[96];
+            std::snprintf(line, sizeof(line), "staleness mean %.2f max %ld ticks, %ld dropped",
+                          stats.mean_staleness(), stats.max_staleness, stats.dropped);
+            lines.push_back(line);
+        }
+        if (learner)
+        {
+            OnlineLearner::Stats stats = learner->get_stats();
+            char line[96];
+            std::snprintf(line, sizeof(line), "online %ld updates, last %.1f ms, %ld dropped",
+                          stats.updates, stats.last_update_seconds * 1e3, stats.dropped);
+            lines.push_back(line);
+        }
+
+        SDL_Color textcolor = {0, 255, 0, 255};
+        for (const std::string& line : lines)
+        {
+            SDL_Surface* surface = TTF_RenderText_Solid(overlay_font, line.c_str(), textcolor);
+            if (!surface)
+            {
+                continue;
+            }
+            SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
+            SDL_FreeSurface(surface);
+            if (texture)
+            {
+                overlay_lines.push_back(texture);
+            }
+        }
+    }
+
+    int y = 10;
+    for (SDL_Texture* texture : overlay_lines)
+    {
+        int width = 0, height = 0;
+        SDL_QueryTexture(texture, nullptr, nullptr, &width, &height);
+        SDL_Rect quad = {10, y, width, height};
+        SDL_RenderCopy(renderer, texture, nullptr, &quad);
+        y += height;
+    }
+}
 
-    // Cleanup
-    SDL_FreeSurface(textsurface);
-    SDL_DestroyTexture(texttexture);
+void PongGame::clearoverlay()
+{
+    for (SDL_Texture* texture : overlay_lines)
+    {
+        SDL_DestroyTexture(texture);
+    }
+    overlay_lines.clear();
+}
+
+// Sleep off the rest of the frame when vsync is not pacing it
+void PongGame::pace_frame(std::chrono::steady_clock::time_point frame_start)
+{
+    auto remaining = frame_start + frame_period - std::chrono::steady_clock::now();
+    long ms = std::chrono::duration_cast<std::chrono::milliseconds>(remaining).count();
+    if (ms > 0)
+    {
+        SDL_Delay(static_cast<Uint32>(ms));
+    }
 }
 
 // Run
 void PongGame::run(bool useai)
 {
+    using Clock = std::chrono::steady_clock;
+    const Clock::duration step = std::chrono::duration_cast<Clock::duration>(std::chrono::nanoseconds(1000000000 / SIMULATION_HZ));
+    Clock::time_point last = Clock::now();
+    Clock::duration lag = Clock::duration::zero();
+
     // Main game loop
     while (running) {
+        profiler.begin_frame();
+        Clock::time_point frame_start = Clock::now();
+        lag += frame_start - last;
+        last = frame_start;
+
         // Handle events
-        handle_events();
+        {
+            FrameProfiler::Scope timer(profiler, FramePhase::Events);
+            handle_events();
+        }
 
-        // Update game state
-        update_state(useai);
+        // Update game state in fixed steps
+        int steps = 0;
+        while (lag >= step && steps < MAX_STEPS_PER_FRAME)
+        {
+            previous_paddle = sim.get_paddle();
+            previous_ball = sim.get_ball();
+            update_state(useai);
+            lag -= step;
+            ++steps;
+        }
+        if (lag >= step)
+        {
+            lag %= step;
+        }
 
-        // Render game
-        render();
+        // Render game between the last two steps
+        render(std::chrono::duration<double>(lag) / std::chrono::duration<double>(step));
 
         // Control frame rate
-        SDL_Delay(16);  // Approximately 60 FPS
+        if (!vsync)
+        {
+            pace_frame(frame_start);
+        }
+
+        profiler.end_frame();
     }
-}
\ No newline at end of file
+}
@@ -7,11 +7,20 @@
 #include <cstdlib>
 #include <ctime>
 #include <string>
+#include <chrono>
+#include <vector>
+#include <memory>
 #include "config.h"
+#include "pong-sim.h"
+#include "frame-profiler.h"
 
-class PongNeuralNetwork;
+template <typename Scalar>
+class BasicPongNeuralNetwork;
+using PongNeuralNetwork = BasicPongNeuralNetwork<double>;
 
 class PongStateGenerator;
+class AsyncAgent;
+class OnlineLearner;
 
 class PongGame
 {
@@ -19,36 +28,77 @@ private:
     // SDL
     SDL_Window*  window;
     SDL_Renderer* renderer;
-    TTF_Font* font;
+    TTF_Font* font = nullptr;
 
-    // Game objects;
-    SDL_Rect paddle;
-    SDL_Rect ball;
-
-    // Game State
-    int score;
-    int ball_speedx;
-    int ball_speedy;
+    // Game rules, this class only renders them
+    PongSimulation sim;
     bool running;
 
-    // Agent
-    PongNeuralNetwork* network;
+    // The simulation runs at SIMULATION_HZ whatever the render rate. A
+    // frame runs at most MAX_STEPS_PER_FRAME steps, after a longer stall
+    // the backlog is dropped instead of fast-forwarded. Render blends from
+    // the positions before the last step toward the current ones.
+    static const int MAX_STEPS_PER_FRAME = 5;
+    Rect previous_paddle;
+    Rect previous_ball;
+
+    // Frames are paced by vsync when the renderer has it, otherwise by
+    // sleeping off what is left of frame_period (the display refresh)
+    bool vsync = false;
+    std::chrono::steady_clock::duration frame_period;
+
+    // Score text, only re-rendered when the score changes
+    SDL_Texture* score_texture = nullptr;
+    int score_width = 0;
+    int score_height = 0;
+    int rendered_score = -1;
+
+    // Agent, optionally deciding on its own thread (see set_async_agent)
+    // and optionally still learning from play (see set_online_learning)
+    const PongNeuralNetwork* network;
+    std::unique_ptr<OnlineLearner> learner;
+    std::unique_ptr<AsyncAgent> agent;
+
+    // Per-phase frame timing, F3 toggles the overlay showing it. The
+    // overlay text is only re-rendered every OVERLAY_REFRESH_FRAMES frames.
+    static const int OVERLAY_REFRESH_FRAMES = 30;
+    FrameProfiler profiler;
+    bool show_overlay = false;
+    TTF_Font* overlay_font = nullptr;
+    std::vector<SDL_Texture*> overlay_lines;
+    int overlay_age = 0;
 
     // Helper methods
     void init_SDL();
     void handle_events();
     void update_state(bool useai);
-    void render();
-    void reset_ball();
-    void checkcollision();
+    void render(double alpha);
+    void pace_frame(std::chrono::steady_clock::time_point frame_start);
     void renderscore();
-    int findhit(int x, int y, int dx, int dy);
+    void renderoverlay();
+    void clearoverlay();
+
+    // The agent's move, through the learner's newest weights when there is one
+    int decide(const GameState& state);
 
 public:
-    PongGame(PongNeuralNetwork* net);
+    PongGame(const PongNeuralNetwork* net);
     ~PongGame();
 
     void run(bool useai);
+
+    // Timing of the frames played so far, enable it before run to trace them all
+    FrameProfiler& get_profiler() { return profiler; }
+
+    // Run the network on its own thread, each step then uses the newest
+    // move it has decided instead of waiting for inference
+    void set_async_agent(bool enabled);
+    const AsyncAgent* get_async_agent() const { return agent.get(); }
+
+    // Keep training a copy of the network on the states of this game in
+    // the background, decisions switch to its weights as they are published
+    void set_online_learning(bool enabled);
+    const OnlineLearner* get_online_learner() const { return learner.get(); }
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,364 @@
+#include "quantized-network.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+// Int8 inputs padded to this many columns so the dot product loop has no tail
+const int QUANTIZED_LANES = 16;
+
+// Largest int8 magnitude used, symmetric so negation never overflows
+const int QUANTIZED_MAX = 127;
+
+static int8_t quantize_value(double value, double scale)
+{
+    long q = std::lround(value / scale);
+    return static_cast<int8_t>(std::max<long>(-QUANTIZED_MAX, std::min<long>(QUANTIZED_MAX, q)));
+}
+
+// Entries in the hidden layers' tanh table
+const int ACTIVATION_TABLE_SIZE = 1024;
+
+// tanh is within half an int8 step of +-1 beyond this, so the table ends here
+const double ACTIVATION_RANGE = 3.2;
+
+// Width of one table entry in real accumulator units
+const double ACTIVATION_STEP = 2.0 * ACTIVATION_RANGE / ACTIVATION_TABLE_SIZE;
+
+// Fraction bits of the fixed point requantization multipliers
+const int MULTIPLIER_SHIFT = 32;
+
+// Row length of the in-memory weights
+static int padded_stride(int cols)
+{
+    return (cols + QUANTIZED_LANES - 1) / QUANTIZED_LANES * QUANTIZED_LANES;
+}
+
+// round(127 * tanh(x)) sampled at the middle of each entry. An entry is
+// 0.00625 wide, so a looked up value is within 0.4 of an int8 step of the
+// exact one.
+static const std::vector<int8_t>& activation_table()
+{
+    static const std::vector<int8_t> table = [] {
+        std::vector<int8_t> values(ACTIVATION_TABLE_SIZE);
+        const int half = ACTIVATION_TABLE_SIZE / 2;
+        for (int k = 0; k < ACTIVATION_TABLE_SIZE; ++k)
+        {
+            double x = (k - half + 0.5) * ACTIVATION_STEP;
+            values[k] = static_cast<int8_t>(std::lround(std::tanh(x) * QUANTIZED_MAX));
+        }
+        return values;
+    }();
+    return table;
+}
+
+
+
+// Quantization -------------------------------------------------------------
+
+template <typename Scalar>
+bool QuantizedPongNetwork::quantize(const BasicPongNeuralNetwork<Scalar>& network)
+{
+    layer_sizes = network.get_layer_sizes();
+    normalization = network.get_normalization();
+    layers.clear();
+    if (layer_sizes.size() < 2)
+    {
+        std::cerr << "Cannot quantize a network without layers" << std::endl;
+        return false;
+    }
+
+    // Calibrate the input scale from the corners of the game state space
+    double input_range = 0.0;
+    for (int y : {0, SCREEN_HEIGHT})
+    {
+        input_range = std::max(input_range, std::abs((y - normalization.mean_bally) / normalization.std_bally));
+        input_range = std::max(input_range, std::abs((y - normalization.mean_paddley) / normalization.std_paddley));
+    }
+    input_scale = static_cast<float>(input_range > 0 ? input_range / QUANTIZED_MAX : 1.0);
+
+    double activation_scale = input_scale;
+    for (size_t i = 0; i < layer_sizes.size() - 1; ++i)
+    {
+        Layer layer;
+        layer.rows = layer_sizes[i + 1];
+        layer.cols = layer_sizes[i];
+        layer.stride = padded_stride(layer.cols);
+
+        const Scalar* w = network.get_layer_weights(i);
+        const Scalar* b = network.get_layer_biases(i);
+
+        layer.weights.assign(static_cast<size_t>(layer.rows) * layer.stride, 0);
+        layer.row_scales.resize(layer.rows);
+        layer.biases.resize(layer.rows);
+        for (int j = 0; j < layer.rows; ++j)
+        {
+            const Scalar* row = w + static_cast<size_t>(j) * layer.cols;
+            double weight_range = 0.0;
+            for (int k = 0; k < layer.cols; ++k)
+            {
+                weight_range = std::max(weight_range, std::abs(static_cast<double>(row[k])));
+            }
+            float weight_scale = static_cast<float>(weight_range > 0 ? weight_range / QUANTIZED_MAX : 1.0);
+            layer.row_scales[j] = weight_scale;
+
+            for (int k = 0; k < layer.cols; ++k)
+            {
+                layer.weights[static_cast<size_t>(j) * layer.stride + k] = quantize_value(row[k], weight_scale);
+            }
+            layer.biases[j] = static_cast<int32_t>(std::lround(b[j] / (weight_scale * activation_scale)));
+        }
+        layers.push_back(std::move(layer));
+
+        // Hidden layers feed tanh outputs in [-1, 1] to the next layer
+        activation_scale = 1.0 / QUANTIZED_MAX;
+    }
+
+    prepare_layers();
+    return true;
+}
+
+template bool QuantizedPongNetwork::quantize(const BasicPongNeuralNetwork<double>& network);
+template bool QuantizedPongNetwork::quantize(const BasicPongNeuralNetwork<float>& network);
+
+// Hidden rows map an accumulator straight to a table entry. Output rows
+// map onto the scale of the layer's coarsest row, so their accumulators
+// can be ranked against each other.
+void QuantizedPongNetwork::prepare_layers()
+{
+    double activation_scale = input_scale;
+    for (size_t i = 0; i < layers.size(); ++i)
+    {
+        Layer& layer = layers[i];
+        bool hidden = i + 1 < layers.size();
+        double output_scale = *std::max_element(layer.row_scales.begin(), layer.row_scales.end()) * activation_scale;
+
+        layer.multipliers.resize(layer.rows);
+        for (int j = 0; j < layer.rows; ++j)
+        {
+            double accumulator_scale = layer.row_scales[j] * activation_scale;
+            double ratio = accumulator_scale / (hidden ? ACTIVATION_STEP : output_scale);
+            layer.multipliers[j] = std::llround(std::ldexp(ratio, MULTIPLIER_SHIFT));
+        }
+        activation_scale = 1.0 / QUANTIZED_MAX;
+    }
+}
+
+size_t QuantizedPongNetwork::parameter_bytes() const
+{
+    size_t bytes = 0;
+    for (const Layer& layer : layers)
+    {
+        bytes += static_cast<size_t>(layer.rows) * layer.cols * sizeof(int8_t) + layer.rows * (sizeof(float) + sizeof(int32_t));
+    }
+    return bytes;
+}
+
+
+
+// Save and load -------------------------------------------------------------
+
+bool QuantizedPongNetwork::save(const std::string& filename) const
+{
+    QuantizedFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, QUANTIZED_FILE_MAGIC, sizeof(header.magic));
+    header.version = QUANTIZED_FILE_VERSION;
+    header.num_layers = static_cast<uint32_t>(layer_sizes.size());
+    header.mean_bally = normalization.mean_bally;
+    header.std_bally = normalization.std_bally;
+    header.mean_paddley = normalization.mean_paddley;
+    header.std_paddley = normalization.std_paddley;
+    header.input_scale = input_scale;
+
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        std::cerr << "Error opening file: " << filename << std::endl;
+        return false;
+    }
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (int size : layer_sizes)
+    {
+        int32_t value = size;
+        file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    // Rows go out without the in-memory padding
+    for (const Layer& layer : layers)
+    {
+        file.write(reinterpret_cast<const char*>(layer.row_scales.data()), layer.rows * sizeof(float));
+        file.write(reinterpret_cast<const char*>(layer.biases.data()), layer.rows * sizeof(int32_t));
+        for (int j = 0; j < layer.rows; ++j)
+        {
+            file.write(reinterpret_cast<const char*>(layer.weights.data() + static_cast<size_t>(j) * layer.stride), layer.cols);
+        }
+    }
+
+    if (!file)
+    {
+        std::cerr << "Error writing quantized model file: " << filename << std::endl;
+        return false;
+    }
+
+    std::cout << "Saved quantized model of " << parameter_bytes() << " bytes to " << filename << std::endl;
+    return true;
+}
+
+bool QuantizedPongNetwork::load(const std::string& filename)
+{
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open())
+    {
+        std::cerr << "Error opening file: " << filename << std::endl;
+        return false;
+    }
+
+    QuantizedFileHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, QUANTIZED_FILE_MAGIC, sizeof(header.magic)) != 0)
+    {
+        std::cerr << "Not a quantized pong model file: " << filename << std::endl;
+        return false;
+    }
+    if (header.version != QUANTIZED_FILE_VERSION)
+    {
+        std::cerr << "Unsupported quantized model file version " << header.version << ": " << filename << std::endl;
+        return false;
+    }
+
+    std::vector<int> arch(header.num_layers);
+    for (int& size : arch)
+    {
+        int32_t value = 0;
+        file.read(reinterpret_cast<char*>(&value), sizeof(value));
+        size = value;
+    }
+    if (!file || arch.size() < 2 || arch[0] < 2 || *std::min_element(arch.begin(), arch.end()) <= 0)
+    {
+        std::cerr << "Corrupt quantized model architecture: " << filename << std::endl;
+        return false;
+    }
+
+    // Widen each packed row to the kernel's stride as it is read
+    std::vector<Layer> loaded(arch.size() - 1);
+    for (size_t i = 0; i < loaded.size(); ++i)
+    {
+        Layer& layer = loaded[i];
+        layer.rows = arch[i + 1];
+        layer.cols = arch[i];
+        layer.stride = padded_stride(layer.cols);
+        layer.row_scales.resize(layer.rows);
+        layer.biases.resize(layer.rows);
+        layer.weights.assign(static_cast<size_t>(layer.rows) * layer.stride, 0);
+
+        file.read(reinterpret_cast<char*>(layer.row_scales.data()), layer.rows * sizeof(float));
+        file.read(reinterpret_cast<char*>(layer.biases.data()), layer.rows * sizeof(int32_t));
+        for (int j = 0; j < layer.rows; ++j)
+        {
+            file.read(reinterpret_cast<char*>(layer.weights.data() + static_cast<size_t>(j) * layer.stride), layer.cols);
+        }
+    }
+    if (!file)
+    {
+        std::cerr << "Corrupt quantized model parameters: " << filename << std::endl;
+        return false;
+    }
+
+    layer_sizes = arch;
+    layers = std::move(loaded);
+    normalization = {header.mean_bally, header.std_bally, header.mean_paddley, header.std_paddley};
+    input_scale = header.input_scale;
+    prepare_layers();
+    return true;
+}
+
+
+
+// Inference ----------------------------------------------------------------
+
+void QuantizedPongNetwork::quantize_input(const GameState& state, int8_t* out) const
+{
+    std::fill_n(out, layers[0].stride, 0);
+    out[0] = quantize_value((state.bally - normalization.mean_bally) / normalization.std_bally, input_scale);
+    out[1] = quantize_value((state.paddley - normalization.mean_paddley) / normalization.std_paddley, input_scale);
+}
+
+void QuantizedPongNetwork::prepare_workspace(QuantizedWorkspace& workspace) const
+{
+    size_t widest = 0;
+    size_t rows = 0;
+    for (const Layer& layer : layers)
+    {
+        widest = std::max<size_t>(widest, layer.stride);
+        rows = std::max<size_t>(rows, layer.rows);
+    }
+    if (workspace.current.size() < widest || workspace.accumulators.size() < rows)
+    {
+        workspace.current.resize(widest);
+        workspace.next.resize(widest);
+        workspace.accumulators.resize(rows);
+    }
+}
+
+int QuantizedPongNetwork::predict_move(const GameState& gamestate, QuantizedWorkspace& workspace) const
+{
+    prepare_workspace(workspace);
+    int8_t* current = workspace.current.data();
+    int8_t* next = workspace.next.data();
+    int32_t* accumulators = workspace.accumulators.data();
+
+    quantize_input(gamestate, current);
+    for (size_t i = 0; i < layers.size(); ++i)
+    {
+        const Layer& layer = layers[i];
+        dense_forward_int8(layer.weights.data(), layer.biases.data(), current, accumulators, layer.rows, layer.stride);
+
+        // The output layer is only ranked, so it never leaves the integer domain
+        if (i + 1 == layers.size())
+        {
+            break;
+        }
+
+        // Requantize tanh onto the fixed hidden scale, zeroing the padding
+        const int half = ACTIVATION_TABLE_SIZE / 2;
+        const int8_t* table = activation_table().data();
+        std::fill_n(next, layers[i + 1].stride, 0);
+        for (int j = 0; j < layer.rows; ++j)
+        {
+            int64_t index = ((static_cast<int64_t>(accumulators[j]) * layer.multipliers[j]) >> MULTIPLIER_SHIFT) + half;
+            next[j] = table[std::max<int64_t>(0, std::min<int64_t>(ACTIVATION_TABLE_SIZE - 1, index))];
+        }
+        std::swap(current, next);
+    }
+
+    // Rows have their own scales, rank them on the common one
+    const Layer& output = layers.back();
+    int best = 0;
+    int64_t best_score = static_cast<int64_t>(accumulators[0]) * output.multipliers[0];
+    for (int j = 1; j < output.rows; ++j)
+    {
+        int64_t score = static_cast<int64_t>(accumulators[j]) * output.multipliers[j];
+        if (score > best_score)
+        {
+            best = j;
+            best_score = score;
+        }
+    }
+    return best;
+}
+
+int QuantizedPongNetwork::predict_move(const GameState& gamestate) const
+{
+    thread_local QuantizedWorkspace workspace;
+    return predict_move(gamestate, workspace);
+}
+
+void QuantizedPongNetwork::predict_moves(const int* bally, const int* paddley, int* moves, int count, QuantizedWorkspace& workspace) const
+{
+    for (int n = 0; n < count; ++n)
+    {
+        moves[n] = predict_move({bally[n], paddley[n]}, workspace);
+    }
+}
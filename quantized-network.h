@@ -0,0 +1,142 @@
+#ifndef PONG_QUANTIZED_NETWORK_H
+#define PONG_QUANTIZED_NETWORK_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "config.h"
+#include "dense-kernels.h"
+#include "network.h"
+
+// Scratch buffers for quantized inference
+struct QuantizedWorkspace
+{
+    AlignedVector<int8_t> current;
+    AlignedVector<int8_t> next;
+    std::vector<int32_t> accumulators;
+};
+
+// Quantized model file layout (native byte order):
+//
+//   QuantizedFileHeader
+//   int32 layer_sizes[num_layers]
+//   per layer: float row_scales[rows], int32 biases[rows],
+//              int8 weights[rows * cols], rows packed back to back
+//
+// Nothing is padded or derived in the file. load widens the rows to the
+// kernel's lane count and rebuilds the requantization factors.
+
+const char QUANTIZED_FILE_MAGIC[8] = {'P', 'O', 'N', 'G', 'Q', '8', '\0', '\0'};
+const uint32_t QUANTIZED_FILE_VERSION = 1;
+
+struct QuantizedFileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t num_layers;
+
+    // Normalization parameters
+    double mean_bally;
+    double std_bally;
+    double mean_paddley;
+    double std_paddley;
+
+    // Real value of one input unit
+    float input_scale;
+    uint32_t reserved;
+};
+
+// Inference only int8 copy of a trained network.
+//
+// Each weight row is int8 with its own scale (the row's largest |w| maps
+// to 127) and each bias is int32 in that row's accumulator scale.
+// Activations are int8 as well: the input scale is calibrated from the
+// range the normalized game state can take, hidden tanh outputs use a
+// fixed 1/127 scale. Dot products accumulate in int32. A per-row fixed
+// point multiplier takes the accumulator to an index into a shared tanh
+// table for hidden layers, and to a common scale for the output argmax,
+// so inference never touches floating point.
+class QuantizedPongNetwork
+{
+private:
+    struct Layer
+    {
+        int rows = 0;
+        int cols = 0;
+
+        // Row length of the in-memory weights, cols padded for the vector loop
+        int stride = 0;
+
+        // Real value of one weight unit in each row
+        std::vector<float> row_scales;
+
+        AlignedVector<int8_t> weights;
+        std::vector<int32_t> biases;
+
+        // Accumulator to tanh table index (hidden layers) or to the common
+        // output scale, in units of 2^-MULTIPLIER_SHIFT. Derived, not stored.
+        std::vector<int64_t> multipliers;
+    };
+
+    std::vector<int> layer_sizes;
+    std::vector<Layer> layers;
+    NormalizationParams normalization;
+
+    // Real value of one input unit
+    float input_scale = 1.0f;
+
+    // Quantize the normalized state into the first layer's input row
+    void quantize_input(const GameState& state, int8_t* out) const;
+
+    // Size the padded weights and derive the multipliers once the rows,
+    // scales and biases are set
+    void prepare_layers();
+
+public:
+    // Quantize a trained network, returns false if it has no layers
+    template <typename Scalar>
+    bool quantize(const BasicPongNeuralNetwork<Scalar>& network);
+
+    bool empty() const { return layers.empty(); }
+
+    // Bytes a saved model takes for its weights, row scales and biases
+    size_t parameter_bytes() const;
+
+    // Write the packed model, see the layout above
+    bool save(const std::string& filename) const;
+
+    // Read a model written by save, returns false on error
+    bool load(const std::string& filename);
+
+    // Size a workspace so later predictions never allocate
+    void prepare_workspace(QuantizedWorkspace& workspace) const;
+
+    // Predict optimal paddle movement based on state
+    int predict_move(const GameState& gamestate, QuantizedWorkspace& workspace) const;
+
+    // Same as above using a per-thread workspace
+    int predict_move(const GameState& gamestate) const;
+
+    // Predict moves for count games given as structure of arrays state
+    void predict_moves(const int* bally, const int* paddley, int* moves, int count, QuantizedWorkspace& workspace) const;
+};
+
+// Fraction of states on which two predictors choose the same move
+template <typename First, typename Second>
+double move_agreement(const First& first, const Second& second, const std::vector<TrainData>& states)
+{
+    if (states.empty())
+    {
+        return 1.0;
+    }
+
+    size_t matches = 0;
+    for (const TrainData& state : states)
+    {
+        GameState input = {state.bally, state.paddley};
+        matches += first.predict_move(input) == second.predict_move(input);
+    }
+    return static_cast<double>(matches) / states.size();
+}
+
+#endif
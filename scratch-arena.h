@@ -0,0 +1,69 @@
+#ifndef PONG_SCRATCH_ARENA_H
+#define PONG_SCRATCH_ARENA_H
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+#include "dense-kernels.h"
+
+// Bump allocator for per-step temporaries. allocate hands out
+// WEIGHT_ALIGNMENT aligned slices, reset releases all of them at once.
+// When a step outgrows the arena a new block is chained on, and the next
+// reset folds every block into one, so after the first step a loop with a
+// fixed working set never touches the heap again.
+class ScratchArena
+{
+private:
+    std::vector<AlignedVector<unsigned char>> blocks;
+    std::size_t used = 0;
+
+public:
+    ScratchArena() = default;
+    explicit ScratchArena(std::size_t bytes)
+    {
+        blocks.emplace_back(bytes);
+    }
+
+    ScratchArena(const ScratchArena&) = delete;
+    ScratchArena& operator=(const ScratchArena&) = delete;
+
+    // Uninitialized room for n values of T, valid until the next reset
+    template <typename T>
+    T* allocate(std::size_t n)
+    {
+        std::size_t bytes = aligned_size<unsigned char>(n * sizeof(T));
+        if (blocks.empty() || used + bytes > blocks.back().size())
+        {
+            blocks.emplace_back(std::max(bytes, capacity()));
+            used = 0;
+        }
+
+        T* ptr = reinterpret_cast<T*>(blocks.back().data() + used);
+        used += bytes;
+        return ptr;
+    }
+
+    // Release every allocation, merging chained blocks into one
+    void reset()
+    {
+        if (blocks.size() > 1)
+        {
+            std::size_t total = capacity();
+            blocks.clear();
+            blocks.emplace_back(total);
+        }
+        used = 0;
+    }
+
+    std::size_t capacity() const
+    {
+        std::size_t total = 0;
+        for (const auto& block : blocks)
+        {
+            total += block.size();
+        }
+        return total;
+    }
+};
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef PONG_SPSC_RING_H
+#define PONG_SPSC_RING_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+// Bounded lock free queue for exactly one producer thread and one consumer
+// thread. Capacity must be a power of two. head and tail live on their own
+// cache lines, so the two threads only share a line when they touch the
+// same slot.
+template <typename T, std::size_t Capacity>
+class SpscRing
+{
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "SpscRing capacity must be a power of two");
+
+private:
+    static const std::size_t CACHE_LINE = 64;
+
+    // Next slot to read, advanced by the consumer
+    alignas(CACHE_LINE) std::atomic<std::size_t> head{0};
+
+    // Next slot to write, advanced by the producer
+    alignas(CACHE_LINE) std::atomic<std::size_t> tail{0};
+
+    alignas(CACHE_LINE) std::array<T, Capacity> slots;
+
+public:
+    // Producer only. Returns false without writing when the ring is full.
+    bool push(const T& value)
+    {
+        std::size_t write = tail.load(std::memory_order_relaxed);
+        if (write - head.load(std::memory_order_acquire) == Capacity)
+        {
+            return false;
+        }
+
+        slots[write & (Capacity - 1)] = value;
+        tail.store(write + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only. Returns false when the ring is empty.
+    bool pop(T& value)
+    {
+        std::size_t read = head.load(std::memory_order_relaxed);
+        if (read == tail.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+
+        value = slots[read & (Capacity - 1)];
+        head.store(read + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only. Drains the ring and keeps the newest entry, false if
+    // there was nothing to read.
+    bool pop_latest(T& value)
+    {
+        std::size_t read = head.load(std::memory_order_relaxed);
+        std::size_t write = tail.load(std::memory_order_acquire);
+        if (read == write)
+        {
+            return false;
+        }
+
+        value = slots[(write - 1) & (Capacity - 1)];
+        head.store(write, std::memory_order_release);
+        return true;
+    }
+
+    // Approximate when the other side is active
+    std::size_t size() const
+    {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+};
+
+#endif
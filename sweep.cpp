@@ -0,0 +1,312 @@
+#include "sweep.h"
+#include "train-data.h"
+#include "training-metrics.h"
+#include "work-stealing-pool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <unordered_set>
+
+// Search space ------------------------------------------------------------
+
+// "10,10" -> {10, 10}
+static bool parse_layers(const std::string& text, std::vector<int>& layers)
+{
+    layers.clear();
+    std::stringstream stream(text);
+    std::string size;
+    while (std::getline(stream, size, ','))
+    {
+        int value = std::atoi(size.c_str());
+        if (value <= 0)
+        {
+            return false;
+        }
+        layers.push_back(value);
+    }
+    return !layers.empty();
+}
+
+bool SweepSpace::load(const std::string& filename)
+{
+    std::ifstream file(filename);
+    if (!file.is_open())
+    {
+        std::cerr << "Error opening file: " << filename << std::endl;
+        return false;
+    }
+
+    std::string line;
+    int line_number = 0;
+    while (std::getline(file, line))
+    {
+        ++line_number;
+        std::stringstream stream(line);
+        std::string name;
+        if (!(stream >> name) || name[0] == '#')
+        {
+            continue;
+        }
+
+        bool ok = true;
+        std::string value;
+        if (name == "layers")
+        {
+            hidden_layers.clear();
+            std::vector<int> layers;
+            while (ok && stream >> value)
+            {
+                ok = parse_layers(value, layers);
+                hidden_layers.push_back(layers);
+            }
+            ok = ok && !hidden_layers.empty();
+        }
+        else if (name == "learning_rate")
+        {
+            learning_rates.clear();
+            double rate;
+            while (stream >> rate)
+            {
+                ok = ok && rate > 0.0;
+                learning_rates.push_back(rate);
+            }
+            ok = ok && !learning_rates.empty() && stream.eof();
+        }
+        else if (name == "epochs" || name == "batch_size")
+        {
+            std::vector<int>& values = name == "epochs" ? epochs : batch_sizes;
+            values.clear();
+            int number;
+            while (stream >> number)
+            {
+                ok = ok && number > 0;
+                values.push_back(number);
+            }
+            ok = ok && !values.empty() && stream.eof();
+        }
+        else if (name == "seed")
+        {
+            seeds.clear();
+            unsigned number;
+            while (stream >> number)
+            {
+                seeds.push_back(number);
+            }
+            ok = !seeds.empty() && stream.eof();
+        }
+        else
+        {
+            ok = false;
+        }
+
+        if (!ok)
+        {
+            std::cerr << "Invalid sweep setting on line " << line_number << " of " << filename << ": " << line << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+static std::vector<int> full_architecture(const std::vector<int>& hidden)
+{
+    std::vector<int> layers{5};
+    layers.insert(layers.end(), hidden.begin(), hidden.end());
+    layers.push_back(3);
+    return layers;
+}
+
+std::vector<SweepConfig> SweepSpace::grid() const
+{
+    std::vector<SweepConfig> configs;
+    for (const auto& hidden : hidden_layers)
+    {
+        for (double rate : learning_rates)
+        {
+            for (int epoch_count : epochs)
+            {
+                for (int batch : batch_sizes)
+                {
+                    for (unsigned seed : seeds)
+                    {
+                        configs.push_back({full_architecture(hidden), rate, epoch_count, batch, seed});
+                    }
+                }
+            }
+        }
+    }
+    return configs;
+}
+
+std::vector<SweepConfig> SweepSpace::sample(int count, unsigned seed) const
+{
+    std::mt19937 gen(seed);
+    auto pick = [&](size_t n) { return std::uniform_int_distribution<size_t>(0, n - 1)(gen); };
+
+    double low = std::log(*std::min_element(learning_rates.begin(), learning_rates.end()));
+    double high = std::log(*std::max_element(learning_rates.begin(), learning_rates.end()));
+    std::uniform_real_distribution<double> log_rate(low, high);
+
+    std::vector<SweepConfig> configs;
+    for (int i = 0; i < count; ++i)
+    {
+        SweepConfig config;
+        config.layers = full_architecture(hidden_layers[pick(hidden_layers.size())]);
+        config.learning_rate = low < high ? std::exp(log_rate(gen)) : std::exp(low);
+        config.epochs = epochs[pick(epochs.size())];
+        config.batch_size = batch_sizes[pick(batch_sizes.size())];
+        config.seed = gen();
+        configs.push_back(config);
+    }
+    return configs;
+}
+
+// Scoring -----------------------------------------------------------------
+
+std::vector<TrainData> holdout_states(const TrainingView& training, int step)
+{
+    auto key = [](int bally, int paddley) { return static_cast<long>(bally) * (SCREEN_HEIGHT + 1) + paddley; };
+
+    std::unordered_set<long> seen;
+    for (size_t i = 0; i < training.size; ++i)
+    {
+        seen.insert(key(training.bally_at(i), training.paddley_at(i)));
+    }
+
+    PongStateGenerator generator(step, step);
+    std::vector<TrainData> states = generator.generateStates();
+    states.erase(std::remove_if(states.begin(), states.end(), [&](const TrainData& state) {
+        return seen.count(key(state.bally, state.paddley)) > 0;
+    }), states.end());
+    return states;
+}
+
+// Keeps the loss of the last epoch
+class FinalLossSink : public TrainingSink
+{
+public:
+    double loss = 0.0;
+
+    void epoch(const EpochMetrics& metrics) override { loss = metrics.loss; }
+};
+
+static SweepResult evaluate(const SweepConfig& config, const TrainingView& data, const std::vector<TrainData>& holdout, long play_ticks)
+{
+    SweepResult result;
+    result.config = config;
+
+    PongNeuralNetwork network(config.layers, config.seed);
+    FinalLossSink sink;
+    TrainOptions options;
+    options.batch_size = config.batch_size;
+    options.sink = &sink;
+
+    auto start = std::chrono::steady_clock::now();
+    network.train(data, config.learning_rate, config.epochs, options);
+    result.train_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.loss = sink.loss;
+
+    PongNeuralNetwork::Workspace workspace;
+    network.prepare_workspace(workspace);
+
+    size_t correct = 0;
+    for (const TrainData& state : holdout)
+    {
+        correct += network.predict_move({state.bally, state.paddley}, workspace) == state.optimalmove;
+    }
+    result.holdout_accuracy = static_cast<double>(correct) / std::max<size_t>(holdout.size(), 1);
+
+    PongSimulation sim;
+    result.play = run_headless(sim, [&](const GameState& state) {
+        return network.predict_move(state, workspace);
+    }, play_ticks);
+    return result;
+}
+
+std::vector<SweepResult> run_sweep(const std::vector<SweepConfig>& configs, const TrainingView& data, const std::vector<TrainData>& holdout, const SweepOptions& options)
+{
+    std::vector<SweepResult> results(configs.size());
+
+    // Rough cost of each run, so the longest ones are dealt first
+    auto cost = [&](const SweepConfig& config) {
+        double weights = 0.0;
+        for (size_t layer = 1; layer < config.layers.size(); ++layer)
+        {
+            weights += static_cast<double>(config.layers[layer - 1] + 1) * config.layers[layer];
+        }
+        return weights * config.epochs;
+    };
+
+    std::vector<size_t> order(configs.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return cost(configs[a]) > cost(configs[b]); });
+
+    std::vector<std::function<void()>> tasks;
+    for (size_t index : order)
+    {
+        tasks.push_back([&, index] {
+            results[index] = evaluate(configs[index], data, holdout, options.play_ticks);
+        });
+    }
+
+    WorkStealingPool pool(std::min<int>(options.threads > 0 ? options.threads : std::max(1u, std::thread::hardware_concurrency()), std::max<int>(configs.size(), 1)));
+    pool.run(tasks);
+    return results;
+}
+
+void rank_sweep_results(std::vector<SweepResult>& results)
+{
+    std::stable_sort(results.begin(), results.end(), [](const SweepResult& a, const SweepResult& b) {
+        if (a.holdout_accuracy != b.holdout_accuracy)
+        {
+            return a.holdout_accuracy > b.holdout_accuracy;
+        }
+        if (a.play.hits_per_rally() != b.play.hits_per_rally())
+        {
+            return a.play.hits_per_rally() > b.play.hits_per_rally();
+        }
+        return a.train_seconds < b.train_seconds;
+    });
+}
+
+// Report ------------------------------------------------------------------
+
+static std::string layers_name(const std::vector<int>& layers)
+{
+    std::string name;
+    for (size_t i = 0; i < layers.size(); ++i)
+    {
+        name += (i > 0 ? "-" : "") + std::to_string(layers[i]);
+    }
+    return name;
+}
+
+void print_sweep_results(const std::vector<SweepResult>& results, std::ostream& out)
+{
+    std::ios_base::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+
+    out << std::left << std::setw(5) << "Rank" << std::setw(16) << "Layers" << std::setw(11) << "Rate" << std::setw(8) << "Epochs" << std::setw(7) << "Batch" << std::setw(12) << "Seed"
+        << std::right << std::setw(10) << "Loss" << std::setw(10) << "Holdout" << std::setw(11) << "Hits/rally" << std::setw(10) << "Train s" << "\n";
+
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const SweepResult& result = results[i];
+        out << std::left << std::setw(5) << i + 1 << std::setw(16) << layers_name(result.config.layers)
+            << std::setw(11) << std::setprecision(3) << std::defaultfloat << result.config.learning_rate
+            << std::setw(8) << result.config.epochs << std::setw(7) << result.config.batch_size << std::setw(12) << result.config.seed
+            << std::right << std::fixed << std::setprecision(4) << std::setw(10) << result.loss
+            << std::setprecision(2) << std::setw(9) << result.holdout_accuracy * 100.0 << "%"
+            << std::setw(11) << result.play.hits_per_rally() << std::setw(10) << result.train_seconds << "\n";
+        out << std::defaultfloat;
+    }
+
+    out.flags(flags);
+    out.precision(precision);
+}
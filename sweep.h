@@ -0,0 +1,86 @@
+#ifndef PONG_SWEEP_H
+#define PONG_SWEEP_H
+
+#include <ostream>
+#include <string>
+#include <vector>
+#include "config.h"
+#include "network.h"
+#include "pong-sim.h"
+
+// One training run of a hyperparameter sweep
+struct SweepConfig
+{
+    // Whole architecture, 5 inputs and 3 outputs included
+    std::vector<int> layers;
+    double learning_rate = 0.0001;
+    int epochs = 500;
+    int batch_size = 1;
+    unsigned seed = 1;
+};
+
+// Values to try for every hyperparameter. A text file sets them with one
+// line per parameter, the name followed by its values:
+//
+//   layers 10,10 32,32 64,64,64
+//   learning_rate 0.0001 0.001
+//   epochs 100 500
+//   batch_size 1 32
+//   seed 1 2 3
+//
+// layers lists hidden layer sizes only. Missing lines keep the defaults.
+struct SweepSpace
+{
+    std::vector<std::vector<int>> hidden_layers{{10, 10}, {32, 32}};
+    std::vector<double> learning_rates{0.0001, 0.001};
+    std::vector<int> epochs{100, 500};
+    std::vector<int> batch_sizes{1, 32};
+    std::vector<unsigned> seeds{1};
+
+    // Returns false if the file is missing or a line does not parse
+    bool load(const std::string& filename);
+
+    // Every combination of the values
+    std::vector<SweepConfig> grid() const;
+
+    // count configurations drawn independently per parameter. The learning
+    // rate is drawn log uniformly between the smallest and largest value
+    // listed, and every draw gets its own weight seed.
+    std::vector<SweepConfig> sample(int count, unsigned seed) const;
+};
+
+// How one configuration did
+struct SweepResult
+{
+    SweepConfig config;
+    double loss = 0.0;              // final epoch
+    double train_seconds = 0.0;
+    double holdout_accuracy = 0.0;  // fraction of held out states
+    SimReport play;
+};
+
+struct SweepOptions
+{
+    // Threads training configurations at once (<= 0 uses all cores). Each
+    // run trains single threaded.
+    int threads = 0;
+
+    // Headless play per configuration
+    long play_ticks = 20000;
+};
+
+// Optimal moves for states on a step pixel grid that the training data
+// does not contain, for scoring generalization
+std::vector<TrainData> holdout_states(const TrainingView& training, int step = 7);
+
+// Train every configuration on its own network and score it on holdout and
+// in headless play. Results come back in the order of configs.
+std::vector<SweepResult> run_sweep(const std::vector<SweepConfig>& configs, const TrainingView& data, const std::vector<TrainData>& holdout, const SweepOptions& options);
+
+// Best first: holdout accuracy, then hits per rally, then training time
+void rank_sweep_results(std::vector<SweepResult>& results);
+
+// Ranked table, one row per result
+void print_sweep_results(const std::vector<SweepResult>& results, std::ostream& out);
+
+#endif
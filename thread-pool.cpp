@@ -0,0 +1,105 @@
+#include "thread-pool.h"
+#include <algorithm>
+
+// Start threads - 1 workers, the caller is the last one
+ThreadPool::ThreadPool(int threads)
+{
+    if (threads <= 0)
+    {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (int i = 1; i < threads; ++i)
+    {
+        workers.emplace_back(&ThreadPool::worker_loop, this);
+    }
+}
+
+// Wake every worker and wait for them to exit
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    start_cv.notify_all();
+
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+// Claim indices until the loop is exhausted
+void ThreadPool::run_indices(const std::function<void(int)>& fn, int count)
+{
+    for (int i = next_index.fetch_add(1); i < count; i = next_index.fetch_add(1))
+    {
+        fn(i);
+    }
+}
+
+// Workers sleep until a new loop generation is published
+void ThreadPool::worker_loop()
+{
+    unsigned long seen = 0;
+    while (true)
+    {
+        const std::function<void(int)>* fn;
+        int count;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            start_cv.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping)
+            {
+                return;
+            }
+            seen = generation;
+
+            // Woke after the loop already finished
+            if (!task)
+            {
+                continue;
+            }
+            fn = task;
+            count = task_count;
+            ++busy_workers;
+        }
+
+        run_indices(*fn, count);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            --busy_workers;
+        }
+        done_cv.notify_one();
+    }
+}
+
+void ThreadPool::parallel_for(int count, const std::function<void(int)>& fn)
+{
+    if (workers.empty() || count <= 1)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            fn(i);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        task = &fn;
+        task_count = count;
+        next_index.store(0);
+        ++generation;
+    }
+    start_cv.notify_all();
+
+    run_indices(fn, count);
+
+    // Wait until every worker that joined this loop has left it
+    std::unique_lock<std::mutex> lock(mutex);
+    done_cv.wait(lock, [&] { return busy_workers == 0; });
+    task = nullptr;
+}
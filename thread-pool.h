@@ -0,0 +1,47 @@
+#ifndef PONG_THREAD_POOL_H
+#define PONG_THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads for data parallel loops. The calling thread
+// takes part in every loop, so a pool of size 1 runs everything inline.
+class ThreadPool
+{
+private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable start_cv;
+    std::condition_variable done_cv;
+
+    // Current loop, published under the mutex
+    const std::function<void(int)>* task = nullptr;
+    int task_count = 0;
+    std::atomic<int> next_index{0};
+    int busy_workers = 0;
+    unsigned long generation = 0;
+    bool stopping = false;
+
+    void worker_loop();
+    void run_indices(const std::function<void(int)>& fn, int count);
+
+public:
+    // threads <= 0 uses every hardware thread
+    explicit ThreadPool(int threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Total threads working on a loop, including the caller
+    int size() const { return static_cast<int>(workers.size()) + 1; }
+
+    // Run fn(i) for every i in [0, count) and wait for all of them
+    void parallel_for(int count, const std::function<void(int)>& fn);
+};
+
+#endif
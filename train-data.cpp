@@ -1,18 +1,33 @@
 #include "train-data.h"
 #include "config.h"
+#include "dataset.h"
+#include "buffered-writer.h"
 #include <cfloat>
 #include <cmath>
 #include <limits>
+#include <algorithm>
+#include <queue>
+#include <unordered_set>
+
+// Setup sampling grid
+PongStateGenerator::PongStateGenerator(int ballstep, int paddlestep) : ball_step(std::max(1, ballstep)), paddle_step(std::max(1, paddlestep))
+{
+}
 
 // Generate possible states
 std::vector<TrainData> PongStateGenerator::generateStates()
 {
+    if (adaptive_budget > 0)
+    {
+        return generateAdaptiveStates(adaptive_budget);
+    }
+
     std::vector<TrainData> states;
 
     // Generate comprehensive set of states
-    for (int bally = 0; bally <= SCREEN_HEIGHT; bally += 10)
+    for (int bally = 0; bally <= SCREEN_HEIGHT; bally += ball_step)
     {
-        for (int paddley = 0; paddley < SCREEN_HEIGHT - PADDLE_HEIGHT; paddley += (SCREEN_HEIGHT - PADDLE_HEIGHT) / 50)
+        for (int paddley = 0; paddley < SCREEN_HEIGHT - PADDLE_HEIGHT; paddley += paddle_step)
         {
             states.push_back({bally, paddley, calculate_movement({bally, paddley})});
         }
@@ -20,6 +35,96 @@ std::vector<TrainData> PongStateGenerator::generateStates()
     return states;
 }
 
+// Refine the cells the optimal move changes in, largest first
+std::vector<TrainData> PongStateGenerator::generateAdaptiveStates(size_t budget)
+{
+    const int max_ball = SCREEN_HEIGHT;
+    const int max_paddle = SCREEN_HEIGHT - PADDLE_HEIGHT - 1;
+
+    std::vector<TrainData> states;
+    std::unordered_set<long> seen;
+    auto sample = [&](int bally, int paddley) {
+        int move = calculate_movement({bally, paddley});
+        if (seen.insert(static_cast<long>(bally) * (max_paddle + 1) + paddley).second)
+        {
+            states.push_back({bally, paddley, move});
+        }
+        return move;
+    };
+
+    // Cell between two sampled ball rows and two sampled paddle columns
+    struct Cell
+    {
+        int ball0, ball1;
+        int paddle0, paddle1;
+
+        long area() const { return static_cast<long>(ball1 - ball0) * (paddle1 - paddle0); }
+        bool operator<(const Cell& other) const { return area() < other.area(); }
+    };
+    std::priority_queue<Cell> mixed;
+    auto consider = [&](const Cell& cell) {
+        int corner = sample(cell.ball0, cell.paddle0);
+        bool differs = sample(cell.ball1, cell.paddle0) != corner;
+        differs = (sample(cell.ball0, cell.paddle1) != corner) || differs;
+        differs = (sample(cell.ball1, cell.paddle1) != corner) || differs;
+        if (differs && (cell.ball1 - cell.ball0 > 1 || cell.paddle1 - cell.paddle0 > 1))
+        {
+            mixed.push(cell);
+        }
+    };
+
+    // Coarse grid over everything, always including the far edges
+    double area = (max_ball + 1.0) * (max_paddle + 1.0);
+    int step = std::max(2, static_cast<int>(std::sqrt(area / std::max<size_t>(budget / 4, 1))));
+    auto grid_lines = [step](int last) {
+        std::vector<int> lines;
+        for (int value = 0; value < last; value += step)
+        {
+            lines.push_back(value);
+        }
+        lines.push_back(last);
+        return lines;
+    };
+    std::vector<int> ball_lines = grid_lines(max_ball);
+    std::vector<int> paddle_lines = grid_lines(max_paddle);
+    for (size_t i = 0; i + 1 < ball_lines.size(); ++i)
+    {
+        for (size_t j = 0; j + 1 < paddle_lines.size(); ++j)
+        {
+            consider({ball_lines[i], ball_lines[i + 1], paddle_lines[j], paddle_lines[j + 1]});
+        }
+    }
+
+    // Split along every axis that is still wider than a pixel
+    while (!mixed.empty() && states.size() < budget)
+    {
+        Cell cell = mixed.top();
+        mixed.pop();
+
+        int ball_mid = (cell.ball0 + cell.ball1) / 2;
+        int paddle_mid = (cell.paddle0 + cell.paddle1) / 2;
+        std::vector<std::pair<int, int>> balls{{cell.ball0, cell.ball1}};
+        std::vector<std::pair<int, int>> paddles{{cell.paddle0, cell.paddle1}};
+        if (ball_mid != cell.ball0)
+        {
+            balls = {{cell.ball0, ball_mid}, {ball_mid, cell.ball1}};
+        }
+        if (paddle_mid != cell.paddle0)
+        {
+            paddles = {{cell.paddle0, paddle_mid}, {paddle_mid, cell.paddle1}};
+        }
+
+        for (const auto& ball : balls)
+        {
+            for (const auto& paddle : paddles)
+            {
+                consider({ball.first, ball.second, paddle.first, paddle.second});
+            }
+        }
+    }
+    return states;
+}
+
 int PongStateGenerator::calculate_movement(const GameState& state) {
     if (state.bally > state.paddley + PADDLE_HEIGHT / 2){
         return 0;
@@ -32,28 +137,91 @@ int PongStateGenerator::calculate_movement(const GameState& state) {
     }
 }
 
+// FNV-1a over the generator inputs
+uint64_t PongStateGenerator::fingerprint() const
+{
+    const int64_t inputs[] = {
+        GENERATOR_VERSION,
+        SCREEN_HEIGHT, SCREEN_WIDTH,
+        PADDLE_WIDTH, PADDLE_HEIGHT, PADDLE_SPEED,
+        BALL_SIZE, BALL_SPEED,
+        ball_step, paddle_step,
+        static_cast<int64_t>(adaptive_budget)
+    };
+
+    uint64_t hash = 1469598103934665603ull;
+    for (int64_t value : inputs)
+    {
+        for (int byte = 0; byte < 8; ++byte)
+        {
+            hash ^= static_cast<uint64_t>(value >> (8 * byte)) & 0xff;
+            hash *= 1099511628211ull;
+        }
+    }
+    return hash;
+}
+
 // Make csv file
-void PongStateGenerator::generateDataCSV(const std::string& filename)
+bool PongStateGenerator::generateDataCSV(const std::string& filename)
 {
     // Generate states
     std::vector<TrainData> states = generateStates();
 
     // Open csv file for writing
-    std::ofstream csvFile(filename);
+    BufferedWriter csvFile(filename);
+    if (!csvFile.is_open())
+    {
+        std::cerr << "Error opening file: " << filename << std::endl;
+        return false;
+    }
 
     // Write CSV Header
-    csvFile << "bally,paddley,optimalmove\n";
+    csvFile.write("bally,paddley,optimalmove\n");
 
     // Process and write each state
     for (const auto& state : states)
     {
         // Write state and mevement to file
-        csvFile << state.bally << ","
-                << state.paddley << ","
-                << state.optimalmove << "\n";
+        csvFile.write_int(state.bally);
+        csvFile.put(',');
+        csvFile.write_int(state.paddley);
+        csvFile.put(',');
+        csvFile.write_int(state.optimalmove);
+        csvFile.put('\n');
+    }
+
+    csvFile.flush();
+    if (!csvFile.good())
+    {
+        std::cerr << "Error writing file: " << filename << std::endl;
+        return false;
     }
 
     std::cout << "Generated CSV with " << states.size() << " Game states to " << filename << std::endl;
+    return true;
+}
+
+// Reuse the csv when its recorded fingerprint matches the current settings
+bool PongStateGenerator::ensureDataCSV(const std::string& filename)
+{
+    std::string fingerprintfile = filename + ".fingerprint";
+    uint64_t expected = fingerprint();
+
+    std::ifstream cached(fingerprintfile);
+    uint64_t recorded = 0;
+    if (cached >> std::hex >> recorded && recorded == expected && std::ifstream(filename).is_open())
+    {
+        std::cout << "Using cached training data " << filename << std::endl;
+        return true;
+    }
+
+    // Only record the fingerprint once the data is fully written
+    if (generateDataCSV(filename))
+    {
+        std::ofstream record(fingerprintfile, std::ios::trunc);
+        record << std::hex << expected << "\n";
+    }
+    return false;
 }
 
 // Read csv file
@@ -61,34 +229,17 @@ std::vector<TrainData> PongStateGenerator::readCSV(const std::string& filename)
 {
     std::vector<TrainData> states;
 
-    // Open csv for reading
-    std::ifstream csvFile(filename);
-    if (!csvFile.is_open())
+    // Parse with the mapped dataset loader
+    TrainingDataset dataset;
+    if (!dataset.load(filename))
     {
-        std::cerr << "Error opening file: " << filename << std::endl;
         return states;
     }
 
-    // Skip header
-    std::string headerline;
-    std::getline(csvFile, headerline);
-
-    // Read state data
-    std::string line;
-    while (std::getline(csvFile, line))
+    states.reserve(dataset.size());
+    for (size_t i = 0; i < dataset.size(); ++i)
     {
-        std::stringstream ss(line);
-        std::string item;
-        TrainData state;
-
-        // Parse line
-        std::getline(ss, item, ','); state.bally = std::stoi(item);
-        std::getline(ss, item, ','); state.paddley = std::stoi(item);
-        std::getline(ss, item, ','); state.optimalmove = std::stoi(item);
-
-        states.push_back(state);
+        states.push_back({dataset.bally()[i], dataset.paddley()[i], dataset.moves()[i]});
     }
-
-    std::cout << "Read " << states.size() << " game states" << std::endl;
     return states;
 }
@@ -1,22 +1,67 @@
+#ifndef PONG_TRAIN_DATA_H
+#define PONG_TRAIN_DATA_H
+
 #include <iostream>
 #include <iomanip>
 #include <vector>
 #include <cmath>
 #include <fstream>
+#include <cstdint>
+#include <string>
+
+#include "config.h"
 
 struct TrainData;
 struct GameState;
 
+// Bump when the generated data changes for the same settings
+const uint32_t GENERATOR_VERSION = 1;
+
 class PongStateGenerator
 {
 private:
-    // Generate possible states
-    std::vector<TrainData> generateStates();
+    // Sampling grid
+    int ball_step;
+    int paddle_step;
+
+    // Sample budget for adaptive sampling, 0 samples the grid
+    size_t adaptive_budget = 0;
 public:
+    // Grid step sizes in pixels for ball y and paddle y
+    PongStateGenerator(int ballstep = 10, int paddlestep = (SCREEN_HEIGHT - PADDLE_HEIGHT) / 50);
+
+    // Make generateStates (and the CSV functions) sample adaptively with
+    // about budget states instead of using the grid, 0 switches back
+    void setAdaptiveBudget(size_t budget) { adaptive_budget = budget; }
+
+    // Every state on the sampling grid with its optimal move, or the
+    // adaptive samples when a budget is set
+    std::vector<TrainData> generateStates();
+
+    // About budget states (never more than budget + 4), dense where the
+    // optimal move changes and sparse elsewhere. A coarse grid that uses
+    // about a quarter of the budget covers the whole state space, then the
+    // largest grid cell whose corners disagree on the move is split into
+    // four, adding its centre and edge midpoints, until the budget is spent
+    // or every such cell is one pixel wide.
+    std::vector<TrainData> generateAdaptiveStates(size_t budget);
+
     // Determine optimal paddle movement
     int calculate_movement(const GameState& state);
 
-    void generateDataCSV(const std::string& filename);
+    // Hash of everything the generated data depends on: generator version,
+    // config.h geometry, the sampling grid and the adaptive budget
+    uint64_t fingerprint() const;
+
+    // Returns false if the file could not be written
+    bool generateDataCSV(const std::string& filename);
+
+    // Generate filename only if it is missing or was made with different
+    // settings. The fingerprint is kept next to it in filename.fingerprint.
+    // Returns true if the cached file was reused.
+    bool ensureDataCSV(const std::string& filename);
 
     std::vector<TrainData> readCSV(const std::string& filename);
-};
\ No newline at end of file
+};
+
+#endif
@@ -0,0 +1,108 @@
+#include "training-metrics.h"
+#include <iostream>
+
+// Text --------------------------------------------------------------------
+
+void TextTrainingSink::epoch(const EpochMetrics& metrics)
+{
+    out << "Epoch " << metrics.epoch << "/" << metrics.epochs << " - Loss: " << metrics.loss << " - Max Gradient: " << metrics.max_gradient << " - Min Gradient: " << metrics.min_gradient
+        << " - Samples/s: " << static_cast<long>(metrics.samples_per_second) << " (" << metrics.threads << " threads)";
+
+    if (metrics.detailed)
+    {
+        out << " - Forward/Backward/Update: " << metrics.forward_seconds * 1e3 << "/" << metrics.backward_seconds * 1e3 << "/" << metrics.update_seconds * 1e3 << " ms";
+
+        out << " - Gradient norms:";
+        for (double norm : metrics.gradient_norms)
+        {
+            out << " " << norm;
+        }
+        out << " - Update ratios:";
+        for (double ratio : metrics.update_ratios)
+        {
+            out << " " << ratio;
+        }
+    }
+    out << '\n';
+}
+
+void TextTrainingSink::finish()
+{
+    out.flush();
+}
+
+// JSON lines --------------------------------------------------------------
+
+JsonLinesTrainingSink::JsonLinesTrainingSink(const std::string& filename) : writer(filename)
+{
+    if (!writer.is_open())
+    {
+        std::cerr << "Error opening file: " << filename << std::endl;
+    }
+}
+
+static void write_array(BufferedWriter& writer, const std::vector<double>& values)
+{
+    writer.put('[');
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        if (i > 0)
+        {
+            writer.write(", ");
+        }
+        writer.write_double(values[i]);
+    }
+    writer.put(']');
+}
+
+void JsonLinesTrainingSink::epoch(const EpochMetrics& metrics)
+{
+    if (!writer.is_open())
+    {
+        return;
+    }
+
+    writer.write("{\"epoch\": ");
+    writer.write_int(metrics.epoch);
+    writer.write(", \"epochs\": ");
+    writer.write_int(metrics.epochs);
+    writer.write(", \"samples\": ");
+    writer.write_int(static_cast<long>(metrics.samples));
+    writer.write(", \"batch_size\": ");
+    writer.write_int(metrics.batch_size);
+    writer.write(", \"threads\": ");
+    writer.write_int(metrics.threads);
+    writer.write(", \"loss\": ");
+    writer.write_double(metrics.loss);
+    writer.write(", \"max_gradient\": ");
+    writer.write_double(metrics.max_gradient);
+    writer.write(", \"min_gradient\": ");
+    writer.write_double(metrics.min_gradient);
+    writer.write(", \"seconds\": ");
+    writer.write_double(metrics.seconds);
+    writer.write(", \"samples_per_second\": ");
+    writer.write_double(metrics.samples_per_second);
+
+    if (metrics.detailed)
+    {
+        writer.write(", \"forward_seconds\": ");
+        writer.write_double(metrics.forward_seconds);
+        writer.write(", \"backward_seconds\": ");
+        writer.write_double(metrics.backward_seconds);
+        writer.write(", \"update_seconds\": ");
+        writer.write_double(metrics.update_seconds);
+        writer.write(", \"gradient_norms\": ");
+        write_array(writer, metrics.gradient_norms);
+        writer.write(", \"update_ratios\": ");
+        write_array(writer, metrics.update_ratios);
+    }
+    writer.write("}\n");
+}
+
+void JsonLinesTrainingSink::finish()
+{
+    if (writer.is_open())
+    {
+        writer.flush();
+    }
+}
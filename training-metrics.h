@@ -0,0 +1,89 @@
+#ifndef PONG_TRAINING_METRICS_H
+#define PONG_TRAINING_METRICS_H
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "buffered-writer.h"
+
+// What one training epoch did
+struct EpochMetrics
+{
+    int epoch = 0;  // 1 based
+    int epochs = 0;
+    std::size_t samples = 0;
+    int batch_size = 1;
+    int threads = 1;
+
+    // Mean cross entropy and the range of output delta magnitudes
+    double loss = 0.0;
+    double max_gradient = 0.0;
+    double min_gradient = 0.0;
+
+    double seconds = 0.0;
+    double samples_per_second = 0.0;
+
+    // Only filled in with TrainOptions::detailed_metrics. Phase times are
+    // summed over every thread, so with several they can exceed seconds.
+    bool detailed = false;
+    double forward_seconds = 0.0;
+    double backward_seconds = 0.0;
+    double update_seconds = 0.0;
+
+    // Per weight layer: RMS over the epoch's updates of the gradient's L2
+    // norm, and the L2 norm of the epoch's weight change relative to the
+    // weights it started from
+    std::vector<double> gradient_norms;
+    std::vector<double> update_ratios;
+};
+
+// Receives metrics while a network trains
+class TrainingSink
+{
+public:
+    virtual ~TrainingSink() = default;
+
+    virtual void epoch(const EpochMetrics& metrics) = 0;
+
+    // Called once after the last epoch
+    virtual void finish() {}
+};
+
+// Discards everything
+class SilentTrainingSink : public TrainingSink
+{
+public:
+    void epoch(const EpochMetrics&) override {}
+};
+
+// One human readable line per epoch. Lines are not flushed one by one, the
+// stream is flushed when training finishes.
+class TextTrainingSink : public TrainingSink
+{
+private:
+    std::ostream& out;
+
+public:
+    explicit TextTrainingSink(std::ostream& stream) : out(stream) {}
+
+    void epoch(const EpochMetrics& metrics) override;
+    void finish() override;
+};
+
+// One JSON object per epoch and line, written through a BufferedWriter
+class JsonLinesTrainingSink : public TrainingSink
+{
+private:
+    BufferedWriter writer;
+
+public:
+    explicit JsonLinesTrainingSink(const std::string& filename);
+
+    bool is_open() const { return writer.is_open(); }
+
+    void epoch(const EpochMetrics& metrics) override;
+    void finish() override;
+};
+
+#endif
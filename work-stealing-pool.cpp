@@ -0,0 +1,137 @@
+#include "work-stealing-pool.h"
+#include <algorithm>
+
+// One queue per thread, then threads - 1 workers, the caller is the last one
+WorkStealingPool::WorkStealingPool(int threads)
+{
+    if (threads <= 0)
+    {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (int i = 0; i < threads; ++i)
+    {
+        queues.emplace_back(new WorkerQueue);
+    }
+    for (int i = 1; i < threads; ++i)
+    {
+        workers.emplace_back(&WorkStealingPool::worker_loop, this, i);
+    }
+}
+
+// Wake every worker and wait for them to exit
+WorkStealingPool::~WorkStealingPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    start_cv.notify_all();
+
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+// Oldest task dealt to this thread
+bool WorkStealingPool::pop_own(int id, Task& task)
+{
+    WorkerQueue& queue = *queues[id];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty())
+    {
+        return false;
+    }
+    task = queue.tasks.front();
+    queue.tasks.pop_front();
+    return true;
+}
+
+// Newest task of the next thread that still has one
+bool WorkStealingPool::steal(int id, Task& task)
+{
+    int count = size();
+    for (int offset = 1; offset < count; ++offset)
+    {
+        WorkerQueue& victim = *queues[(id + offset) % count];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty())
+        {
+            task = victim.tasks.back();
+            victim.tasks.pop_back();
+            steals.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Run tasks until no queue has any left. A batch never adds tasks, so an
+// empty sweep over every queue means this thread is done.
+void WorkStealingPool::work(int id)
+{
+    Task task;
+    while (pop_own(id, task) || steal(id, task))
+    {
+        (*task)();
+
+        if (remaining.fetch_sub(1) == 1)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            done_cv.notify_all();
+        }
+    }
+}
+
+// Workers sleep until a new batch generation is published
+void WorkStealingPool::worker_loop(int id)
+{
+    unsigned long seen = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            start_cv.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping)
+            {
+                return;
+            }
+            seen = generation;
+        }
+
+        // Waking after the batch finished just finds every queue empty
+        work(id);
+    }
+}
+
+void WorkStealingPool::run(const std::vector<std::function<void()>>& tasks)
+{
+    if (tasks.empty())
+    {
+        return;
+    }
+
+    remaining = static_cast<int>(tasks.size());
+    for (size_t i = 0; i < tasks.size(); ++i)
+    {
+        WorkerQueue& queue = *queues[i % queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(&tasks[i]);
+    }
+
+    if (!workers.empty())
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ++generation;
+        }
+        start_cv.notify_all();
+    }
+
+    work(0);
+
+    // Other threads may still be finishing tasks they took
+    std::unique_lock<std::mutex> lock(mutex);
+    done_cv.wait(lock, [&] { return remaining.load() == 0; });
+}
@@ -0,0 +1,72 @@
+#ifndef PONG_WORK_STEALING_POOL_H
+#define PONG_WORK_STEALING_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Worker threads for batches of independent tasks whose costs differ a
+// lot, such as whole training runs. Every thread owns a deque. A batch is
+// dealt round robin across the deques, each thread runs its own tasks
+// front to back and, once it runs dry, steals from the back of another
+// thread's deque. Passing the most expensive tasks first therefore starts
+// them early and leaves only cheap ones to steal near the end.
+//
+// Tasks run for milliseconds to minutes, so each deque is guarded by a
+// plain mutex. The calling thread takes part in every batch, so a pool of
+// size 1 runs everything inline.
+class WorkStealingPool
+{
+private:
+    using Task = const std::function<void()>*;
+
+    struct WorkerQueue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::thread> workers;
+
+    // One per thread, the caller owns queues[0]
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+
+    std::mutex mutex;
+    std::condition_variable start_cv;
+    std::condition_variable done_cv;
+    unsigned long generation = 0;
+    bool stopping = false;
+
+    // Tasks of the current batch not yet finished
+    std::atomic<int> remaining{0};
+    std::atomic<long> steals{0};
+
+    bool pop_own(int id, Task& task);
+    bool steal(int id, Task& task);
+    void work(int id);
+    void worker_loop(int id);
+
+public:
+    // threads <= 0 uses every hardware thread
+    explicit WorkStealingPool(int threads);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    // Total threads working on a batch, including the caller
+    int size() const { return static_cast<int>(queues.size()); }
+
+    // Run every task once and wait for all of them
+    void run(const std::vector<std::function<void()>>& tasks);
+
+    // Tasks that ran on a thread other than the one they were dealt to
+    long steal_count() const { return steals.load(std::memory_order_relaxed); }
+};
+
+#endif